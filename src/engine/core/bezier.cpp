@@ -1,89 +1,361 @@
 //
 // Created by Autumn Sound on 2024/9/30.
 //
-#include <cassert>
-#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
 #include <vector>
 
 #include "engine.hpp"
+#include "line.hpp"
 #include "utils.hpp"
 #include "vector.hpp"
 
 using namespace RenderCore;
 
-void RenderEngine::draw_bezier_curve(const BezierCurve &curve) {
-    std::function<Vector2f(const std::vector<Vector2f> &, float)> de_casteljau =
-        [&](const std::vector<Vector2f> &points, float t) -> Vector2f {
-        if (points.size() == 1) {
-            return points[0];
+namespace {
+
+// 使用前向差分的最高次数，次数更高时差分表的累积误差较大，改用 de Casteljau 算法逐点求值
+constexpr size_t max_forward_difference_degree = 10;
+// 重新建立差分表的间隔步数
+constexpr size_t forward_difference_steps = 16;
+// 曲线采样点分组时每组的线段数
+constexpr size_t curve_chunk_size = 16;
+// 允许的最小偏差（像素），更小的值只会增加分段数
+constexpr double min_curve_tolerance = 1.0 / 16;
+// 一条曲线的分段数上限
+constexpr size_t max_bezier_segments = 1 << 16;
+// 分段数不超过此值时均匀采样，否则从中点细分后分别处理
+constexpr size_t max_uniform_segments = 16;
+
+// 选项中的偏差不合法时使用默认值
+double curve_tolerance(float tolerance) {
+    if (!std::isfinite(tolerance) || tolerance <= 0) {
+        return GlobalOptions{}.curve_tolerance;
+    }
+    return std::max(static_cast<double>(tolerance), min_curve_tolerance);
+}
+
+// 根据控制点在屏幕空间的大小选择分段数
+// n 次曲线均匀分成 N 段时，折线与曲线的偏差不超过 n(n-1)/8 * max|P[i+2] - 2P[i+1] + P[i]| / N²
+// 分段数也不超过控制多边形的长度，即每段至少跨过一个像素
+size_t bezier_segment_count(const std::pmr::vector<Vector2d> &points, double tolerance) {
+    const auto degree = points.size() - 1;
+    double polygon_length = 0;
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        polygon_length += vector_length(points[i + 1] - points[i]);
+    }
+    double max_second_difference = 0;
+    for (size_t i = 0; i + 2 < points.size(); i++) {
+        max_second_difference = std::max(max_second_difference,
+            vector_length(points[i + 2] - 2.0 * points[i + 1] + points[i]));
+    }
+    const auto flatness = std::ceil(std::sqrt(static_cast<double>(degree * (degree - 1)) *
+                                              max_second_difference / (8 * tolerance)));
+    const auto segments = std::min(flatness, std::ceil(polygon_length));
+    // 坐标极大或不是有限值时直接取上限，避免转换为整数时溢出
+    if (!(segments < static_cast<double>(max_bezier_segments))) {
+        return max_bezier_segments;
+    }
+    return std::max(static_cast<size_t>(segments), size_t{1});
+}
+
+Point round_point(const Vector2d &point) {
+    return {static_cast<int>(std::lround(point.x)), static_cast<int>(std::lround(point.y))};
+}
+
+// 把贝塞尔曲线均匀分成 segments 段，除起点外的采样点追加到 samples
+void sample_bezier_uniform(const std::pmr::vector<Vector2d> &points, size_t segments,
+    RenderArena &arena, std::vector<Point> &samples) {
+    const auto degree = points.size() - 1;
+    RenderArena::Scope scope(arena);
+    std::pmr::vector<Vector2d> table(points.size(), &arena);
+    if (degree > max_forward_difference_degree) {
+        // de Casteljau 算法，每一层在同一个数组中原地计算
+        for (size_t s = 1; s < segments; s++) {
+            const double t = static_cast<double>(s) / static_cast<double>(segments);
+            std::copy(points.begin(), points.end(), table.begin());
+            for (size_t n = degree; n > 0; n--) {
+                for (size_t i = 0; i < n; i++) {
+                    table[i] = (1 - t) * table[i] + t * table[i + 1];
+                }
+            }
+            samples.push_back(round_point(table[0]));
+        }
+    } else if (segments > 1) {
+        // 前向差分
+        // 先把控制点转换为幂基形式 B(t) = Σ a[k] t^k，a[k] = C(n,k) Σ (-1)^(k-i) C(k,i) P[i]
+        std::pmr::vector<Vector2d> coefficients(points.size(), &arena);
+        double binomial_n = 1;  // C(n, k)
+        for (size_t k = 0; k <= degree; k++) {
+            Vector2d sum{0, 0};
+            double binomial_k = 1;  // C(k, i)
+            for (size_t i = 0; i <= k; i++) {
+                const double sign = (k - i) % 2 == 0 ? 1 : -1;
+                sum += sign * binomial_k * points[i];
+                binomial_k = binomial_k * static_cast<double>(k - i) / static_cast<double>(i + 1);
+            }
+            coefficients[k] = binomial_n * sum;
+            binomial_n = binomial_n * static_cast<double>(degree - k) / static_cast<double>(k + 1);
         }
-        std::vector<Vector2f> new_points;
-        for (size_t i = 0; i < points.size() - 1; i++) {
-            new_points.push_back((1 - t) * points[i] + t * points[i + 1]);
+        const double h = 1.0 / static_cast<double>(segments);
+        const auto evaluate = [&](double t) {
+            Vector2d value = coefficients[degree];
+            for (size_t k = degree; k > 0; k--) {
+                value = value * t + coefficients[k - 1];
+            }
+            return value;
+        };
+        for (size_t s = 1; s < segments; s++) {
+            // 差分表的误差随步数按 n 次方增长，每隔一段用精确值重新建立
+            // 用从第 s - 1 个采样点开始的 n + 1 个值建立差分表，table[j] 为 j 阶差分
+            if ((s - 1) % forward_difference_steps == 0) {
+                for (size_t j = 0; j <= degree; j++) {
+                    table[j] = evaluate(static_cast<double>(s - 1 + j) * h);
+                }
+                for (size_t j = 1; j <= degree; j++) {
+                    for (size_t i = degree; i >= j; i--) {
+                        table[i] -= table[i - 1];
+                    }
+                }
+            }
+            // 每一步只需要 n 次加法
+            for (size_t j = 0; j < degree; j++) {
+                table[j] += table[j + 1];
+            }
+            samples.push_back(round_point(table[0]));
         }
-        return de_casteljau(new_points, t);
-    };
+    }
+    // 终点直接使用最后一个控制点，不受累积误差影响
+    samples.push_back(round_point(points.back()));
+}
 
-    std::vector<Vector2f> points;
-    for (const auto &point : curve) {
-        points.emplace_back(static_cast<float>(point.x), static_cast<float>(point.y));
+// 自适应细分
+// 分段数较多时用 de Casteljau 算法从中点把曲线分成两半，两半各自按自身的弯曲程度选择分段数，
+// 平直的部分使用较少的分段；每细分一层分段数上限减半，整条曲线的分段数不超过上限
+void subdivide_bezier(const std::pmr::vector<Vector2d> &points, double tolerance, size_t budget,
+    RenderArena &arena, std::vector<Point> &samples) {
+    const auto segments = std::min(bezier_segment_count(points, tolerance), budget);
+    if (segments <= max_uniform_segments) {
+        sample_bezier_uniform(points, segments, arena, samples);
+        return;
+    }
+    const auto degree = points.size() - 1;
+    RenderArena::Scope scope(arena);
+    std::pmr::vector<Vector2d> left(points.size(), &arena);
+    std::pmr::vector<Vector2d> right(points, &arena);
+    // 每一层的第一个点属于前一半，最后一个点属于后一半
+    for (size_t n = degree; n > 0; n--) {
+        left[degree - n] = right[0];
+        for (size_t i = 0; i < n; i++) {
+            right[i] = 0.5 * (right[i] + right[i + 1]);
+        }
+    }
+    left[degree] = right[0];
+    subdivide_bezier(left, tolerance, budget / 2, arena, samples);
+    subdivide_bezier(right, tolerance, budget / 2, arena, samples);
+}
+
+// 对贝塞尔曲线采样，采样点追加到 samples
+// 采样点是折线的顶点，折线与曲线之间的偏差不超过 tolerance 像素
+// 起点与 samples 的最后一个点相同时不重复添加
+void sample_bezier(const std::pmr::vector<Vector2d> &points, double tolerance, RenderArena &arena,
+    std::vector<Point> &samples) {
+    const auto first = round_point(points.front());
+    if (samples.empty() || samples.back().x != first.x || samples.back().y != first.y) {
+        samples.push_back(first);
+    }
+    if (points.size() > 1) {
+        subdivide_bezier(points, tolerance, max_bezier_segments, arena, samples);
+    }
+}
+
+// 查找 u 所在的节点区间 [knots[span], knots[span + 1])，限制在曲线的定义域 [p, n - 1] 内
+size_t find_knot_span(const std::vector<float> &knots, size_t p, size_t n, float u) {
+    const auto it = std::upper_bound(knots.begin() + static_cast<std::ptrdiff_t>(p),
+        knots.begin() + static_cast<std::ptrdiff_t>(n), u);
+    const auto span = static_cast<size_t>(it - knots.begin());
+    return std::clamp(span, p + 1, n) - 1;
+}
+
+// 迭代的 de Boor 算法，在 d 中原地计算
+// 第 r 层使用参数 u[r - 1]，参数都相同时就是曲线在该点的值，不同时是开花（blossom）的值
+Vector2d de_boor(const std::vector<Point> &control_points, const std::vector<float> &knots,
+    size_t p, size_t span, const double *u, std::pmr::vector<Vector2d> &d) {
+    for (size_t j = 0; j <= p; j++) {
+        const auto &point = control_points[span - p + j];
+        d[j] = Vector2d(static_cast<double>(point.x), static_cast<double>(point.y));
+    }
+    for (size_t r = 1; r <= p; r++) {
+        for (size_t j = p; j >= r; j--) {
+            const double left = knots[span - p + j];
+            const double right = knots[span + 1 + j - r];
+            const double alpha = right > left ? (u[r - 1] - left) / (right - left) : 0.0;
+            d[j] = (1.0 - alpha) * d[j - 1] + alpha * d[j];
+        }
+    }
+    return d[p];
+}
+
+}  // namespace
+
+void RenderEngine::sample_bezier_curve(
+    const BezierCurve &curve, std::vector<Point> &samples) const {
+    samples.clear();
+    if (curve.empty()) {
+        return;
     }
-    for (float t = 0; t <= 1; t += 0.001) {
-        auto point = de_casteljau(points, t);
-        draw_point(point.x, point.y);
+    // 临时数组从渲染内存池分配，函数返回时整体回收
+    RenderArena::Scope scope(render_arena_);
+    std::pmr::vector<Vector2d> points(&render_arena_);
+    points.reserve(curve.size());
+    for (const auto &point : curve) {
+        points.emplace_back(static_cast<double>(point.x), static_cast<double>(point.y));
     }
+    const auto tolerance = curve_tolerance(global_options_.curve_tolerance);
+    sample_bezier(points, tolerance, render_arena_, samples);
 }
 
-void RenderEngine::draw_bspline_curve(const BsplineCurve &curve) {
+void RenderEngine::sample_bspline_curve(
+    const BsplineCurve &curve, std::vector<Point> &samples) const {
     const auto &control_points = curve.control_points;
     const auto &knots = curve.knots;
+    samples.clear();
     // 控制点数量
-    auto n = control_points.size();
+    const auto n = control_points.size();
     // 节点数量
-    auto m = knots.size();
-    // 阶数
-    auto p = m - n - 1;
-    assert(m - n - 1 > 0);  // 阶数大于1，p是size_t类型，不能 assert(p > 0)
-
-    std::function<Vector2f(size_t, size_t, float)> de_boor = [&](size_t k, size_t i,
-                                                                 float u) -> Vector2f {
-        if (k == 0) {
-            return {
-                static_cast<float>(control_points[i].x), static_cast<float>(control_points[i].y)};
-        }
+    const auto m = knots.size();
+    // 阶数为 p + 1，p 为次数
+    if (n == 0 || m <= n + 1) {
+        return;
+    }
+    const auto p = m - n - 1;
+    // 曲线的定义域 [knots[p], knots[n]]
+    const float u_start = knots[p];
+    const float u_end = knots[n];
+    if (!(u_start < u_end)) {
+        return;
+    }
 
-        // 计算alpha系数
-        float alpha = (!near_equal(knots[i + p + 1 - k], knots[i]))
-                          ? (u - knots[i]) / (knots[i + p + 1 - k] - knots[i])
-                          : 0.0f;
+    // 每个非空的节点区间是一段 p 次多项式曲线，转换为贝塞尔曲线后用贝塞尔曲线的快速路径采样
+    // 区间 [a, b] 上第 j 个贝塞尔控制点是开花 f(a, ..., a, b, ..., b) 的值，其中 b 有 j 个
+    const auto tolerance = curve_tolerance(global_options_.curve_tolerance);
+    RenderArena::Scope scope(render_arena_);
+    std::pmr::vector<Vector2d> d(p + 1, &render_arena_);
+    std::pmr::vector<Vector2d> bezier(p + 1, &render_arena_);
+    std::pmr::vector<double> u(p, &render_arena_);
+    // 二分查找起点所在的区间，之后随着参数增大逐个区间前进
+    for (auto span = find_knot_span(knots, p, n, u_start); span < n; span++) {
+        const double a = knots[span];
+        const double b = knots[span + 1];
+        if (!(a < b)) {
+            continue;
+        }
+        for (size_t j = 0; j <= p; j++) {
+            std::fill(u.begin(), u.end() - static_cast<std::ptrdiff_t>(j), a);
+            std::fill(u.end() - static_cast<std::ptrdiff_t>(j), u.end(), b);
+            bezier[j] = de_boor(control_points, knots, p, span, u.data(), d);
+        }
+        sample_bezier(bezier, tolerance, render_arena_, samples);
+    }
+}
 
-        return (1.0f - alpha) * de_boor(k - 1, i - 1, u) + alpha * de_boor(k - 1, i, u);
-    };
+void RenderEngine::chunk_curve_samples(
+    const std::vector<Point> &samples, std::vector<CurveChunk> &chunks) {
+    chunks.clear();
+    int steps = 0;
+    for (size_t begin = 1; begin < samples.size(); begin += curve_chunk_size) {
+        const size_t end = min(begin + curve_chunk_size, samples.size());
+        CurveChunk chunk{{}, steps};
+        for (size_t i = begin - 1; i < end; i++) {
+            chunk.bounds = bounds_union(chunk.bounds,
+                make_bounds(samples[i].x, samples[i].y, samples[i].x + 1, samples[i].y + 1));
+            if (i >= begin) {
+                steps += max(abs(samples[i].x - samples[i - 1].x),
+                    abs(samples[i].y - samples[i - 1].y));
+            }
+        }
+        chunks.push_back(chunk);
+    }
+}
 
-    // 寻找对应的节点区间 i 的函数
-    auto find_knot_interval = [&](float u) -> size_t {
-        for (size_t j = 0; j < knots.size() - 1; ++j) {
-            if (u >= knots[j] && u < knots[j + 1]) {
-                return j;
+void RenderEngine::draw_curve_samples(
+    const std::vector<Point> &samples, const std::vector<CurveChunk> &chunks) {
+    if (samples.empty()) {
+        return;
+    }
+    // 线宽大于 1 时沿采样点组成的折线描边
+    if (pen_options_.width > 1) {
+        draw_stroke(samples, false);
+        return;
+    }
+    // 相邻采样点之间用 Bresenham 算法连接成线段
+    // 公共端点只绘制一次，半透明时不会重复混合；线型的下标沿整条曲线连续计数
+    // 闭合的曲线（如变换后的圆）终点与起点重合，终点不再绘制
+    const bool closed = samples.size() > 2 && samples.front() == samples.back();
+    if (!closed) {
+        draw_point(samples[0].x, samples[0].y, 0);
+    }
+    // 跳过与绘制区域不相交的组
+    const int start_index = closed ? 0 : 1;
+    for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+        if (!bounds_overlap(chunks[chunk].bounds, scissor_)) {
+            continue;
+        }
+        int index = start_index + chunks[chunk].steps;
+        const size_t begin = 1 + chunk * curve_chunk_size;
+        const size_t end = min(begin + curve_chunk_size, samples.size());
+        for (size_t i = begin; i < end; i++) {
+            const auto &p0 = samples[i - 1];
+            const auto &p1 = samples[i];
+            const int dx = abs(p1.x - p0.x);
+            const int dy = -abs(p1.y - p0.y);
+            const int sx = p0.x < p1.x ? 1 : -1;
+            const int sy = p0.y < p1.y ? 1 : -1;
+            // 第 k 步（1 <= k <= steps）的像素线型下标为 index + k - 1
+            const bool x_major = dx >= -dy;
+            const int steps = max(dx, -dy);
+            const int base = index;
+            index += steps;
+            // 跳过与绘制区域不相交的线段，完全在区域内的线段逐步绘制，
+            // 跨过区域边界的线段只绘制落在区域内的步
+            const auto bounds = make_bounds(
+                min(p0.x, p1.x), min(p0.y, p1.y), max(p0.x, p1.x) + 1, max(p0.y, p1.y) + 1);
+            if (!bounds_overlap(bounds, scissor_)) {
+                continue;
+            }
+            int x = p0.x, y = p0.y;
+            int error = dx + dy;
+            int first = 1, last = steps;
+            if (!scissor_.contains(bounds.min_x, bounds.min_y) ||
+                !scissor_.contains(bounds.max_x - 1, bounds.max_y - 1)) {
+                const LineStepper stepper{p0, sx, sy, x_major, steps, x_major ? -dy : dx, steps};
+                const auto range = stepper.clip(scissor_, 1, steps);
+                if (range.first > range.second) {
+                    continue;
+                }
+                first = static_cast<int>(range.first);
+                last = static_cast<int>(range.second);
+                // 从第 first - 1 步的状态开始：x 每移动一次误差项加 dy，y 每移动一次加 dx
+                const int done = first - 1;
+                const auto moves = static_cast<int>(stepper.moves(done));
+                const auto position = stepper.at(done);
+                x = position.x;
+                y = position.y;
+                error += (x_major ? done : moves) * dy + (x_major ? moves : done) * dx;
+            }
+            for (int k = first; k <= last; k++) {
+                const int e2 = 2 * error;
+                if (e2 >= dy) {
+                    error += dy;
+                    x += sx;
+                }
+                if (e2 <= dx) {
+                    error += dx;
+                    y += sy;
+                }
+                draw_point(x, y, base + k - 1);
             }
         }
-        return 0;  // 如果 u 不在范围内，返回 0
-    };
-
-    // 绘制曲线
-    constexpr int num_samples = 1000;            // 采样点的数量，值越大曲线越平滑
-    float u_start = knots[p];                    // 曲线起始参数
-    float u_end = knots[n];                      // 曲线结束参数
-    float du = (u_end - u_start) / num_samples;  // 每次步进的参数增量
-
-    assert(!near_equal(u_start, u_end));
-
-    for (float u = u_start; u <= u_end; u += du) {
-        // 寻找对应的节点区间 l
-        auto l = find_knot_interval(u);
-        // 使用 De Boor 算法计算 u 对应的曲线点
-        Vector2f point = de_boor(p, l, u);
-        // 绘制点
-        draw_point(point.x, point.y);
     }
 }
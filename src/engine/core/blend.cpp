@@ -0,0 +1,193 @@
+#include "blend.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RENDERENGINE_BLEND_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+using namespace RenderCore;
+
+namespace {
+
+using BlendRowFunction = void (*)(uint32_t *, size_t, const BlendSource &);
+
+void blend_row_scalar(uint32_t *row, size_t count, const BlendSource &source) {
+    for (size_t i = 0; i < count; i++) {
+        row[i] = blend_pixel(row[i], source);
+    }
+}
+
+#ifdef RENDERENGINE_BLEND_X86
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RENDERENGINE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RENDERENGINE_TARGET_AVX2
+#endif
+
+// x86-64 一定支持 SSE2
+// 浮点内核与 blend_color 的运算顺序相同：dst / 255 * inv_alpha + src_term，截断到 [0, 1] 后乘 255 取整
+// 一个寄存器为一个像素的四个分量
+inline __m128i blend_float_sse2(__m128i pixel, __m128 src, __m128 inv_alpha) {
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 dst = _mm_div_ps(_mm_cvtepi32_ps(pixel), scale);
+    __m128 color = _mm_add_ps(src, _mm_mul_ps(dst, inv_alpha));
+    color = _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_mul_ps(color, scale));
+}
+
+// 定点内核：(src_fixed + dst * inv_alpha_fixed) >> 8
+// 一个寄存器为两个像素的 16 位分量
+inline __m128i blend_fixed_sse2(__m128i pixel, __m128i src, __m128i inv_alpha) {
+    return _mm_srli_epi16(_mm_adds_epu16(_mm_mullo_epi16(pixel, inv_alpha), src), 8);
+}
+
+void blend_row_sse2(uint32_t *row, size_t count, const BlendSource &source) {
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    if (source.mode == BlendMode::FLOAT) {
+        const auto &t = source.src_term;
+        const __m128 src = _mm_setr_ps(t.r, t.g, t.b, t.a);
+        const __m128 inv_alpha = _mm_set1_ps(source.inv_alpha);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+            const __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+            const __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+            const __m128i p0 = blend_float_sse2(_mm_unpacklo_epi16(lo, zero), src, inv_alpha);
+            const __m128i p1 = blend_float_sse2(_mm_unpackhi_epi16(lo, zero), src, inv_alpha);
+            const __m128i p2 = blend_float_sse2(_mm_unpacklo_epi16(hi, zero), src, inv_alpha);
+            const __m128i p3 = blend_float_sse2(_mm_unpackhi_epi16(hi, zero), src, inv_alpha);
+            const __m128i result =
+                _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), result);
+        }
+    } else {
+        const auto *s = reinterpret_cast<const int16_t *>(source.src_fixed);
+        const __m128i src = _mm_setr_epi16(s[0], s[1], s[2], s[3], s[0], s[1], s[2], s[3]);
+        const __m128i inv_alpha = _mm_set1_epi16(static_cast<int16_t>(source.inv_alpha_fixed));
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+            const __m128i lo = blend_fixed_sse2(_mm_unpacklo_epi8(pixels, zero), src, inv_alpha);
+            const __m128i hi = blend_fixed_sse2(_mm_unpackhi_epi8(pixels, zero), src, inv_alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+    blend_row_scalar(row + i, count - i, source);
+}
+
+// 与 SSE2 内核相同，每次处理 8 个像素
+// unpack/pack 只在 128 位通道内进行，两者对称，像素顺序不变
+RENDERENGINE_TARGET_AVX2 inline __m256i blend_float_avx2(
+    __m256i pixel, __m256 src, __m256 inv_alpha) {
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    const __m256 dst = _mm256_div_ps(_mm256_cvtepi32_ps(pixel), scale);
+    __m256 color = _mm256_add_ps(src, _mm256_mul_ps(dst, inv_alpha));
+    color = _mm256_min_ps(_mm256_max_ps(color, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_mul_ps(color, scale));
+}
+
+RENDERENGINE_TARGET_AVX2 inline __m256i blend_fixed_avx2(
+    __m256i pixel, __m256i src, __m256i inv_alpha) {
+    return _mm256_srli_epi16(_mm256_adds_epu16(_mm256_mullo_epi16(pixel, inv_alpha), src), 8);
+}
+
+RENDERENGINE_TARGET_AVX2 void blend_row_avx2(
+    uint32_t *row, size_t count, const BlendSource &source) {
+    size_t i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    if (source.mode == BlendMode::FLOAT) {
+        const auto &t = source.src_term;
+        const __m256 src = _mm256_setr_ps(t.r, t.g, t.b, t.a, t.r, t.g, t.b, t.a);
+        const __m256 inv_alpha = _mm256_set1_ps(source.inv_alpha);
+        for (; i + 8 <= count; i += 8) {
+            const __m256i pixels =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+            const __m256i lo = _mm256_unpacklo_epi8(pixels, zero);
+            const __m256i hi = _mm256_unpackhi_epi8(pixels, zero);
+            const __m256i p0 = blend_float_avx2(_mm256_unpacklo_epi16(lo, zero), src, inv_alpha);
+            const __m256i p1 = blend_float_avx2(_mm256_unpackhi_epi16(lo, zero), src, inv_alpha);
+            const __m256i p2 = blend_float_avx2(_mm256_unpacklo_epi16(hi, zero), src, inv_alpha);
+            const __m256i p3 = blend_float_avx2(_mm256_unpackhi_epi16(hi, zero), src, inv_alpha);
+            const __m256i result =
+                _mm256_packus_epi16(_mm256_packs_epi32(p0, p1), _mm256_packs_epi32(p2, p3));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(row + i), result);
+        }
+    } else {
+        const auto *s = reinterpret_cast<const int16_t *>(source.src_fixed);
+        const __m256i src = _mm256_setr_epi16(s[0], s[1], s[2], s[3], s[0], s[1], s[2], s[3],
+            s[0], s[1], s[2], s[3], s[0], s[1], s[2], s[3]);
+        const __m256i inv_alpha = _mm256_set1_epi16(static_cast<int16_t>(source.inv_alpha_fixed));
+        for (; i + 8 <= count; i += 8) {
+            const __m256i pixels =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+            const __m256i lo = blend_fixed_avx2(_mm256_unpacklo_epi8(pixels, zero), src, inv_alpha);
+            const __m256i hi = blend_fixed_avx2(_mm256_unpackhi_epi8(pixels, zero), src, inv_alpha);
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i *>(row + i), _mm256_packus_epi16(lo, hi));
+        }
+    }
+    blend_row_sse2(row + i, count - i, source);
+}
+
+bool cpu_supports_avx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // 操作系统需要保存 AVX 寄存器状态
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+#endif
+
+BlendKernel select_blend_kernel() {
+#ifdef RENDERENGINE_BLEND_X86
+    if (cpu_supports_avx2()) {
+        return BlendKernel::AVX2;
+    }
+    return BlendKernel::SSE2;
+#else
+    return BlendKernel::SCALAR;
+#endif
+}
+
+BlendRowFunction blend_row_function(BlendKernel kernel) {
+    switch (kernel) {
+#ifdef RENDERENGINE_BLEND_X86
+        case BlendKernel::AVX2:
+            return blend_row_avx2;
+        case BlendKernel::SSE2:
+            return blend_row_sse2;
+#endif
+        default:
+            return blend_row_scalar;
+    }
+}
+
+}  // namespace
+
+BlendKernel RenderCore::blend_kernel() {
+    static const auto kernel = select_blend_kernel();
+    return kernel;
+}
+
+void RenderCore::blend_row(uint32_t *row, size_t count, const BlendSource &source) {
+    static const auto function = blend_row_function(blend_kernel());
+    function(row, count, source);
+}
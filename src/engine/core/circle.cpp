@@ -3,44 +3,202 @@
 //
 #include "circle.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
+#include <memory_resource>
 #include <numbers>
 #include <utility>
 
 #include "engine.hpp"
+#include "stroke.hpp"
 
 using namespace RenderCore;
 
-void RenderEngine::draw_circle_midpoint(const Point &center, int radius) {
+namespace {
+
+// 中点画圆算法，对圆上的每个像素调用 plot(octant, dx, dy)，dx、dy 为相对圆心的偏移
+// 每一步的 8 个对称点分别属于 8 个八分区间，八分区间 k 为极角 [-π + kπ/4, -π + (k + 1)π/4]
+// 极角为 atan2(dy, dx)（屏幕坐标，y 轴向下），同一八分区间内的点的极角随步数单调变化
+// 同一步中重合的点（x == 0 或 x == y 时）只输出一次，半透明时不会重复混合
+// 只遍历可能落在 clip 内的步，只输出落在 clip 内的点
+template <typename Plot>
+void midpoint_circle(const Point &center, int radius, const Bounds &clip, Plot &&plot) {
+    if (clip.empty()) {
+        return;
+    }
     int x = 0;
     int y = radius;
-    int d = 1 - radius;  // 初始决策参数
+    int64_t d = 1 - radius;  // 初始决策参数
+
+    // clip 相对圆心的偏移范围
+    const int64_t min_dx = int64_t{clip.min_x} - center.x;
+    const int64_t max_dx = int64_t{clip.max_x} - 1 - center.x;
+    const int64_t min_dy = int64_t{clip.min_y} - center.y;
+    const int64_t max_dy = int64_t{clip.max_y} - 1 - center.y;
+    const auto emit = [&](int octant, int dx, int dy) {
+        if (dx >= min_dx && dx <= max_dx && dy >= min_dy && dy <= max_dy) {
+            plot(octant, dx, dy);
+        }
+    };
 
     // 绘制圆的八个对称点
-    auto draw_circle_points = [&](int cx, int cy) {
-        draw_point(cx + x, cy + y);
-        draw_point(cx - x, cy + y);
-        draw_point(cx + x, cy - y);
-        draw_point(cx - x, cy - y);
-        draw_point(cx + y, cy + x);
-        draw_point(cx - y, cy + x);
-        draw_point(cx + y, cy - x);
-        draw_point(cx - y, cy - x);
+    const auto plot_points = [&]() {
+        // 最后一步可能越过对角线（x > y），此时每个点落在相邻的八分区间
+        const int swap = x > y ? 1 : 0;
+        emit(5 ^ swap, x, y);
+        if (x != 0) {
+            emit(6 ^ swap, -x, y);
+        }
+        if (y != 0) {
+            emit(2 ^ swap, x, -y);
+            if (x != 0) {
+                emit(1 ^ swap, -x, -y);
+            }
+        }
+        if (x == y) {
+            return;
+        }
+        emit(4 ^ swap, y, x);
+        if (y != 0) {
+            emit(7 ^ swap, -y, x);
+        }
+        if (x != 0) {
+            emit(3 ^ swap, y, -x);
+            if (y != 0) {
+                emit(0 ^ swap, -y, -x);
+            }
+        }
+    };
+
+    // x 每步加 1，第 x 步的 y 是满足 x² + y² - y < r² 的最大整数，决策参数为 (x + 1)² + y² - y - r²
+    // 上面的 y 在离对角线两步以内可能不成立，此时从更早的一步开始
+    const int64_t r2 = int64_t{radius} * radius;
+    const auto max_row = [&](int64_t column) {
+        const int64_t rest = r2 - column * column;
+        const auto root = std::sqrt(max(1.0 + 4.0 * static_cast<double>(rest), 0.0));
+        auto row = static_cast<int64_t>((1 + root) / 2);
+        while (row > 0 && row * (row - 1) >= rest) {
+            row--;
+        }
+        while ((row + 1) * row < rest) {
+            row++;
+        }
+        return row;
+    };
+    // 绘制第 first 到 last 步的对称点
+    const auto walk = [&](int first, int last) {
+        x = first;
+        y = radius;
+        for (; x > 0; x--) {
+            const auto row = max_row(x);
+            if (row >= x + 2) {
+                y = static_cast<int>(row);
+                break;
+            }
+        }
+        d = int64_t{x + 1} * (x + 1) + int64_t{y} * y - y - r2;
+        while (true) {
+            if (x >= first) {
+                plot_points();  // 绘制对称点
+            }
+            if (x >= last || x >= y) {
+                break;
+            }
+            if (d < 0) {
+                d += 2 * x + 3;  // 更新决策参数
+            } else {
+                d += 2 * (x - y) + 5;  // 更新决策参数
+                y--;                   // y 减小
+            }
+            x++;  // x 增加
+        }
     };
 
-    draw_circle_points(center.x, center.y);  // 绘制初始点
+    // 相对圆心的偏移落在 [lo, hi] 内的坐标，其绝对值的范围
+    const auto abs_range = [](int64_t lo, int64_t hi) {
+        if (lo > 0) {
+            return std::pair{lo, hi};
+        }
+        return hi < 0 ? std::pair{-hi, -lo} : std::pair<int64_t, int64_t>{0, max(-lo, hi)};
+    };
+    // 第 x 步的 y 满足 r² - y² - y <= x² < r² - y² + y，由 y 的范围反解出 x 的范围，两端留出余量
+    const auto columns = [&](const std::pair<int64_t, int64_t> &rows) {
+        const auto root = [](int64_t value) {
+            return static_cast<int64_t>(std::sqrt(static_cast<double>(max<int64_t>(value, 0))));
+        };
+        const auto [lo, hi] = rows;
+        return std::pair{root(r2 - hi * hi - hi) - 2, root(r2 - lo * lo + lo) + 3};
+    };
+    // 偏移为 (±x, ±y) 的点只在 x 落在横向偏移的绝对值范围内、y 落在纵向偏移的绝对值范围内时
+    // 可能在 clip 内，偏移为 (±y, ±x) 的点反之；遍历在 x 超过 r / √2 + 1 之前结束
+    const int end = max(static_cast<int>(radius / std::numbers::sqrt2) + 1, 0);
+    const auto steps = [&](const std::pair<int64_t, int64_t> &major,
+                           const std::pair<int64_t, int64_t> &minor) {
+        const auto range = columns(minor);
+        const auto first = max<int64_t>(max(major.first, range.first), 0);
+        const auto last = min<int64_t>(min(major.second, range.second), end);
+        return first > last ? std::pair{1, 0}
+                            : std::pair{static_cast<int>(first), static_cast<int>(last)};
+    };
+    const auto x_range = abs_range(min_dx, max_dx);
+    const auto y_range = abs_range(min_dy, max_dy);
+    auto a = steps(x_range, y_range);
+    auto b = steps(y_range, x_range);
+    if (a.first > a.second || (b.first <= b.second && a.first > b.first)) {
+        std::swap(a, b);
+    }
+    // 两段相交或相邻时合并为一段
+    if (b.first <= b.second && b.first <= a.second + 1) {
+        a.second = max(a.second, b.second);
+        b = {1, 0};
+    }
+    for (const auto &[first, last] : {a, b}) {
+        if (first <= last) {
+            walk(first, last);
+        }
+    }
+}
 
-    while (x < y) {
-        if (d < 0) {
-            d += 2 * x + 3;  // 更新决策参数
+// 圆弧端点的方向
+// 所在的八分区间和方向向量在绘制前计算一次，逐点判断时不再需要三角函数
+struct ArcBound {
+    // 所在的八分区间，小于 -π 时为 -1，大于 π 时为 8
+    int octant;
+    // 方向向量
+    double x;
+    double y;
+
+    explicit ArcBound(double angle) : x(std::cos(angle)), y(std::sin(angle)) {
+        if (angle < -std::numbers::pi) {
+            octant = -1;
+        } else if (angle > std::numbers::pi) {
+            octant = 8;
         } else {
-            d += 2 * (x - y) + 5;  // 更新决策参数
-            y--;                   // y 减小
+            const auto index = std::floor((angle + std::numbers::pi) / (std::numbers::pi / 4));
+            octant = std::min(static_cast<int>(index), 7);
         }
-        x++;                                     // x 增加
-        draw_circle_points(center.x, center.y);  // 绘制对称点
     }
+};
+
+}  // namespace
+
+void RenderEngine::draw_circle_midpoint(const Point &center, int radius) {
+    // 线宽大于 1 时把圆折线化后描边
+    if (pen_options_.width > 1) {
+        if (radius < 0) {
+            return;
+        }
+        RenderArena::Scope scope(render_arena_);
+        std::pmr::vector<Vector2d> points(&render_arena_);
+        Stroker::flatten_arc(Vector2d(center.x, center.y), radius, radius, -std::numbers::pi,
+            std::numbers::pi, points);
+        draw_stroke(points, true);
+        return;
+    }
+    midpoint_circle(center, radius, scissor_,
+        [&](int, int dx, int dy) { draw_point(center.x + dx, center.y + dy); });
 }
 
 void RenderEngine::draw_arc_midpoint(
@@ -48,42 +206,50 @@ void RenderEngine::draw_arc_midpoint(
     if (start_angle >= end_angle) {
         std::swap(start_angle, end_angle);
     }
-    auto draw_arc_points = [&](int x, int y) {
-        // 判断点是否在圆弧内
-        auto angle = std::atan2(y - center.y, x - center.x);
-        if (angle >= start_angle && angle <= end_angle) {
-            draw_point(x, y);
+    // 圆弧由极角 atan2(dy, dx) 在 [start_angle, end_angle] 内的点组成
+    if (std::isnan(start_angle) || std::isnan(end_angle) || radius < 0) {
+        return;
+    }
+    // 线宽大于 1 时把 [-π, π] 内的部分折线化后描边
+    if (pen_options_.width > 1) {
+        const double start = std::max<double>(start_angle, -std::numbers::pi);
+        const double end = std::min<double>(end_angle, std::numbers::pi);
+        if (start > end) {
+            return;
         }
-    };
-
-    int x = 0;
-    int y = radius;
-    int d = 1 - radius;  // 初始决策参数
-
-    // 绘制圆的八个对称点
-    auto draw_circle_points = [&](int cx, int cy) {
-        draw_arc_points(cx + x, cy + y);
-        draw_arc_points(cx - x, cy + y);
-        draw_arc_points(cx + x, cy - y);
-        draw_arc_points(cx - x, cy - y);
-        draw_arc_points(cx + y, cy + x);
-        draw_arc_points(cx - y, cy + x);
-        draw_arc_points(cx + y, cy - x);
-        draw_arc_points(cx - y, cy - x);
-    };
-
-    draw_circle_points(center.x, center.y);  // 绘制初始点
-
-    while (x < y) {
-        if (d < 0) {
-            d += 2 * x + 3;  // 更新决策参数
-        } else {
-            d += 2 * (x - y) + 5;  // 更新决策参数
-            y--;                   // y 减小
+        RenderArena::Scope scope(render_arena_);
+        std::pmr::vector<Vector2d> points(&render_arena_);
+        Stroker::flatten_arc(Vector2d(center.x, center.y), radius, radius, start, end, points);
+        draw_stroke(points, false);
+        return;
+    }
+    // 半径为 0 时只有圆心一个点，极角为 atan2(0, 0) = 0
+    if (radius == 0) {
+        if (start_angle <= 0 && end_angle >= 0) {
+            draw_point(center.x, center.y);
         }
-        x++;                                     // x 增加
-        draw_circle_points(center.x, center.y);  // 绘制对称点
+        return;
     }
+    const ArcBound start(start_angle);
+    const ArcBound end(end_angle);
+    // 整个八分区间都在范围外的点直接跳过，端点所在的八分区间才需要逐点判断
+    // 同一八分区间内的点与端点的夹角小于 π，用叉积的符号比较极角的大小
+    bool active[8];
+    for (int k = 0; k < 8; k++) {
+        active[k] = k >= start.octant && k <= end.octant;
+    }
+    midpoint_circle(center, radius, scissor_, [&](int octant, int dx, int dy) {
+        if (!active[octant]) {
+            return;
+        }
+        if (octant == start.octant && start.x * dy - start.y * dx < 0) {
+            return;
+        }
+        if (octant == end.octant && dx * end.y - dy * end.x < 0) {
+            return;
+        }
+        draw_point(center.x + dx, center.y + dy);
+    });
 }
 
 // 根据三点求圆心和半径
@@ -160,3 +326,105 @@ void RenderEngine::draw_arc(const Arc &arc) {
         }
     }
 }
+
+void RenderEngine::draw_ellipse(const Ellipse &ellipse) {
+    const auto &center = ellipse.center;
+    const int64_t a = ellipse_radius(ellipse.radius_x);
+    const int64_t b = ellipse_radius(ellipse.radius_y);
+    const auto color = pen_options_.fill_color;
+    // 线宽大于 1 时，按行填充内部后沿折线化的椭圆描边
+    const bool stroke = pen_options_.width > 1;
+    const auto draw_outline = [&]() {
+        RenderArena::Scope scope(render_arena_);
+        std::pmr::vector<Vector2d> points(&render_arena_);
+        Stroker::flatten_arc(Vector2d(center.x, center.y), static_cast<double>(a),
+            static_cast<double>(b), -std::numbers::pi, std::numbers::pi, points);
+        draw_stroke(points, true);
+    };
+
+    // 绘制四个对称点，重合的点只绘制一次
+    const auto plot_points = [&](int x, int y) {
+        if (stroke) {
+            return;
+        }
+        draw_point(center.x + x, center.y + y);
+        if (x != 0) {
+            draw_point(center.x - x, center.y + y);
+        }
+        if (y != 0) {
+            draw_point(center.x + x, center.y - y);
+            if (x != 0) {
+                draw_point(center.x - x, center.y - y);
+            }
+        }
+    };
+    // 每一行第一个边界点的 x 最小，行内 |dx| 小于它的像素都在椭圆内部，用一段水平线段填充
+    // 填充的像素与边线不重叠，半透明时不会重复混合
+    // 只有 |dy| 落在 [row_first, row_last] 内的行可能在绘制区域内，y 单调减小，
+    // 大于 row_last 的行跳过，小于 row_first 时结束
+    const int64_t top = int64_t{scissor_.min_y} - center.y;
+    const int64_t bottom = int64_t{scissor_.max_y} - 1 - center.y;
+    const int64_t row_first = top > 0 ? top : (bottom < 0 ? -bottom : 0);
+    const int64_t row_last = top > 0 ? bottom : (bottom < 0 ? -top : max(-top, bottom));
+    int64_t row = b + 1;
+    const auto plot = [&](int64_t x, int64_t y) {
+        if (y > row_last) {
+            return;
+        }
+        if (y != row) {
+            row = y;
+            const auto x0 = center.x - static_cast<int>(x) + 1;
+            const auto x1 = center.x + static_cast<int>(x);
+            draw_span(center.y + static_cast<int>(y), x0, x1, color);
+            if (y != 0) {
+                draw_span(center.y - static_cast<int>(y), x0, x1, color);
+            }
+        }
+        plot_points(static_cast<int>(x), static_cast<int>(y));
+    };
+
+    // 退化为水平线段
+    if (b == 0) {
+        if (stroke) {
+            draw_outline();
+            return;
+        }
+        for (int64_t x = 0; x <= a; x++) {
+            plot_points(static_cast<int>(x), 0);
+        }
+        return;
+    }
+
+    // 中点椭圆算法，决策参数放大 4 倍以避免小数
+    const int64_t a2 = a * a;
+    const int64_t b2 = b * b;
+    int64_t x = 0;
+    int64_t y = b;
+    // 区域 1：切线斜率绝对值小于 1，x 每步加 1
+    int64_t d1 = 4 * b2 - 4 * a2 * b + a2;
+    while (b2 * x < a2 * y && y >= row_first) {
+        plot(x, y);
+        if (d1 < 0) {
+            d1 += 4 * b2 * (2 * x + 3);
+        } else {
+            d1 += 4 * (b2 * (2 * x + 3) + a2 * (2 - 2 * y));
+            y--;
+        }
+        x++;
+    }
+    // 区域 2：切线斜率绝对值大于等于 1，y 每步减 1
+    int64_t d2 = b2 * (2 * x + 1) * (2 * x + 1) + 4 * a2 * (y - 1) * (y - 1) - 4 * a2 * b2;
+    while (y >= row_first) {
+        plot(x, y);
+        if (d2 > 0) {
+            d2 += 4 * a2 * (3 - 2 * y);
+        } else {
+            d2 += 4 * (b2 * (2 * x + 2) + a2 * (3 - 2 * y));
+            x++;
+        }
+        y--;
+    }
+    if (stroke) {
+        draw_outline();
+    }
+}
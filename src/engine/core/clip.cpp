@@ -1,6 +1,7 @@
 //
 // Created by Autumn Sound on 2024/9/20.
 //
+#include <memory_resource>
 #include <variant>
 #include <vector>
 
@@ -204,24 +205,29 @@ void RenderEngine::clip_sutherland_hodgman(const Polygon &window, std::optional<
         return Vector2f{p1.x + t * poly_vec.x, p1.y + t * poly_vec.y};
     };
 
+    // 临时的点集从渲染内存池分配，函数返回时整体回收
+    RenderArena::Scope scope(render_arena_);
     // 将点转换为浮点数
-    std::vector<Vector2f> window_f(window.size());
+    std::pmr::vector<Vector2f> window_f(window.size(), &render_arena_);
     for (size_t i = 0; i < window.size(); i++) {
         window_f[i] = Vector2f{static_cast<float>(window[i].x), static_cast<float>(window[i].y)};
     }
-    std::vector<Vector2f> polygon_f(polygon_ref.size());
+    std::pmr::vector<Vector2f> polygon_f(polygon_ref.size(), &render_arena_);
     for (size_t i = 0; i < polygon_ref.size(); i++) {
         polygon_f[i] =
             Vector2f{static_cast<float>(polygon_ref[i].x), static_cast<float>(polygon_ref[i].y)};
     }
 
+    // 每条边的裁剪结果，与 polygon_f 交替使用
+    std::pmr::vector<Vector2f> new_polygon(&render_arena_);
+    new_polygon.reserve(polygon_f.size() + window.size());
     // 遍历窗口边界
     for (size_t i = 0; i < window.size(); i++) {
         const Vector2f &edge_start = window_f[i];
         const Vector2f &edge_end = window_f[(i + 1) % window.size()];
 
         // 对于窗口的每条边，计算裁剪后的多边形
-        std::vector<Vector2f> new_polygon;
+        new_polygon.clear();
         for (size_t j = 0; j < polygon_f.size(); j++) {
             const Vector2f &p1 = polygon_f[j];
             const Vector2f &p2 = polygon_f[(j + 1) % polygon_f.size()];
@@ -241,7 +247,7 @@ void RenderEngine::clip_sutherland_hodgman(const Polygon &window, std::optional<
                 new_polygon.push_back(p2);
             }
         }
-        polygon_f = new_polygon;
+        polygon_f.swap(new_polygon);
     }
 
     // 将浮点数转换为整数
@@ -1,7 +1,9 @@
 //
 // Created by Autumn Sound on 2024/9/20.
 //
-#include <deque>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
 
 #include "engine.hpp"
 
@@ -12,37 +14,85 @@ void RenderEngine::draw_fill(const Fill &fill) {
 }
 
 void RenderEngine::fill_polygon_seedfill(const Fill &fill) {
-    // 种子填充算法
-    std::deque<Point> queue;
-    queue.push_back(fill.seed);
+    // 扫描线种子填充算法
+    // 栈中保存已经填充的一段像素 [x0, x1] 和扫描方向 dy，弹出时扫描相邻的第 y + dy 行，
+    // 把这一行中与它相邻的每段可填充像素整段填充，并压入这段像素沿原方向继续扫描
+    // 新的一段超出原来那段的部分，在反方向上也可能连通，再沿反方向压入
+    // 八连通时，与一段像素相邻的范围向左右各多出一个像素
+    struct Segment {
+        int y;
+        int x0;
+        int x1;
+        int dy;
+    };
 
+    const auto seed = fill.seed;
+    if (!frame_bounds().contains(seed.x, seed.y)) {
+        return;
+    }
     const auto border_color = vector_to_color(pen_options_.color);
     const auto fill_color = vector_to_color(pen_options_.fill_color);
+    const auto fillable = [&](const uint32_t *row, int x) {
+        return row[x] != border_color && row[x] != fill_color;
+    };
+    if (!fillable(frame_buffer_->pixels(seed.y), seed.x)) {
+        return;
+    }
+    const int extend = fill.connectivity == Fill::Connectivity::EIGHT ? 1 : 0;
 
-    while (!queue.empty()) {
-        auto point = queue.front();
-        queue.pop_front();
-
-        if (frame_buffer_->get_pixel(point.x, point.y) == border_color) {
-            continue;
-        }
-        if (frame_buffer_->get_pixel(point.x, point.y) == fill_color) {
-            continue;
-        }
-
-        frame_buffer_->set_pixel(point.x, point.y, fill_color);
-
-        if (point.x > 0) {
-            queue.emplace_back(point.x - 1, point.y);
+    // 栈从渲染内存池分配，函数返回时回收，下次填充时重复使用同一块内存
+    RenderArena::Scope scope(render_arena_);
+    std::pmr::vector<Segment> stack(&render_arena_);
+    stack.reserve(height_);
+    // 只压入相邻行在画面内的段
+    const auto push = [&](int y, int x0, int x1, int dy) {
+        if (y + dy >= 0 && y + dy < height_) {
+            stack.push_back({y, x0, x1, dy});
         }
-        if (point.x < width_ - 1) {
-            queue.emplace_back(point.x + 1, point.y);
+    };
+    // 把第 y 行中包含 x 的一段可填充像素整段填充，返回这一段的范围
+    // from_left 为 false 时，调用方已经确认 x 左边的像素不可填充
+    const auto fill_run = [&](uint32_t *row, int y, int x, bool from_left) {
+        int x0 = x;
+        int x1 = x;
+        if (from_left) {
+            while (x0 > 0 && fillable(row, x0 - 1)) {
+                x0--;
+            }
         }
-        if (point.y > 0) {
-            queue.emplace_back(point.x, point.y - 1);
+        while (x1 + 1 < width_ && fillable(row, x1 + 1)) {
+            x1++;
         }
-        if (point.y < height_ - 1) {
-            queue.emplace_back(point.x, point.y + 1);
+        frame_buffer_->fill_span(y, x0, x1 + 1, fill_color);
+        return std::pair{x0, x1};
+    };
+
+    // 种子所在的一段向上下两个方向扫描
+    const auto [seed_x0, seed_x1] = fill_run(frame_buffer_->pixels(seed.y), seed.y, seed.x, true);
+    push(seed.y, seed_x0, seed_x1, 1);
+    push(seed.y, seed_x0, seed_x1, -1);
+    while (!stack.empty()) {
+        const auto parent = stack.back();
+        stack.pop_back();
+        const int y = parent.y + parent.dy;
+        auto *row = frame_buffer_->pixels(y);
+        const int begin = max(parent.x0 - extend, 0);
+        const int end = min(parent.x1 + extend, width_ - 1);
+        for (int x = begin; x <= end; x++) {
+            if (!fillable(row, x)) {
+                continue;
+            }
+            const auto [x0, x1] = fill_run(row, y, x, x == begin);
+            push(y, x0, x1, parent.dy);
+            // 左右两端超出原来那段的部分
+            if (x0 < parent.x0) {
+                push(y, x0, parent.x0 - 1, -parent.dy);
+            }
+            if (x1 > parent.x1) {
+                push(y, parent.x1 + 1, x1, -parent.dy);
+            }
+            // x1 + 1 不可填充
+            x = x1 + 1;
         }
     }
 }
@@ -0,0 +1,161 @@
+#include "frame_encoder.hpp"
+
+using namespace RenderCore;
+
+namespace {
+
+void write_u16(uint8_t *out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void write_u32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+void write_u64(uint8_t *out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+uint16_t read_u16(const uint8_t *in) { return static_cast<uint16_t>(in[0] | (in[1] << 8)); }
+
+uint32_t read_u32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= static_cast<uint32_t>(in[i]) << (i * 8);
+    }
+    return value;
+}
+
+uint64_t read_u64(const uint8_t *in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= static_cast<uint64_t>(in[i]) << (i * 8);
+    }
+    return value;
+}
+
+// 分块在位图中的范围
+struct TileRect {
+    int x0, y0, x1, y1;
+};
+
+TileRect tile_rect(const Bitmap &frame, int tile_size, uint32_t index) {
+    const int columns = (frame.width() + tile_size - 1) / tile_size;
+    const int x0 = static_cast<int>(index % columns) * tile_size;
+    const int y0 = static_cast<int>(index / columns) * tile_size;
+    return {x0, y0, std::min(x0 + tile_size, frame.width()),
+        std::min(y0 + tile_size, frame.height())};
+}
+
+}  // namespace
+
+void FrameEncoder::write_header(FrameType type, const Bitmap &frame, uint64_t version,
+    uint64_t base_version, uint32_t tile_count) {
+    uint8_t *out = buffer_.data();
+    out[0] = static_cast<uint8_t>(type);
+    out[1] = 0;
+    write_u16(out + 2, static_cast<uint16_t>(tile_size_));
+    write_u32(out + 4, static_cast<uint32_t>(frame.width()));
+    write_u32(out + 8, static_cast<uint32_t>(frame.height()));
+    write_u64(out + 12, version);
+    write_u64(out + 20, base_version);
+    write_u32(out + 28, tile_count);
+}
+
+const FrameEncoder::Buffer &FrameEncoder::encode_key(const Bitmap &frame, uint64_t version) {
+    // 像素按 RGBA 字节顺序存储，直接复制
+    buffer_.resize(header_size + frame.size());
+    write_header(FrameType::KEY, frame, version, 0, 0);
+    std::memcpy(buffer_.data() + header_size, frame.data(), frame.size());
+    return buffer_;
+}
+
+const FrameEncoder::Buffer &FrameEncoder::encode_delta(
+    const Bitmap &base, uint64_t base_version, const Bitmap &frame, uint64_t version) {
+    assert(base.width() == frame.width() && base.height() == frame.height());
+    buffer_.resize(header_size);
+    const int columns = (frame.width() + tile_size_ - 1) / tile_size_;
+    const int rows = (frame.height() + tile_size_ - 1) / tile_size_;
+    uint32_t tile_count = 0;
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            const auto index = static_cast<uint32_t>(row * columns + column);
+            const auto rect = tile_rect(frame, tile_size_, index);
+            const size_t row_bytes = static_cast<size_t>(rect.x1 - rect.x0) * 4;
+            // 逐行比较，遇到第一处不同即可确定分块改变
+            bool changed = false;
+            for (int y = rect.y0; y < rect.y1 && !changed; y++) {
+                changed = std::memcmp(base.line(y) + rect.x0 * 4, frame.line(y) + rect.x0 * 4,
+                              row_bytes) != 0;
+            }
+            if (!changed) {
+                continue;
+            }
+            const size_t offset = buffer_.size();
+            buffer_.resize(offset + 4 + row_bytes * (rect.y1 - rect.y0));
+            uint8_t *out = buffer_.data() + offset;
+            write_u32(out, index);
+            out += 4;
+            for (int y = rect.y0; y < rect.y1; y++) {
+                std::memcpy(out, frame.line(y) + rect.x0 * 4, row_bytes);
+                out += row_bytes;
+            }
+            tile_count++;
+        }
+    }
+    write_header(FrameType::DELTA, frame, version, base_version, tile_count);
+    return buffer_;
+}
+
+bool RenderCore::decode_frame(
+    Bitmap &target, const uint8_t *data, size_t size, DecodedFrame &result) {
+    if (size < FrameEncoder::header_size || data[0] > static_cast<uint8_t>(FrameType::DELTA)) {
+        return false;
+    }
+    const int tile_size = read_u16(data + 2);
+    if (tile_size == 0 || read_u32(data + 4) != static_cast<uint32_t>(target.width()) ||
+        read_u32(data + 8) != static_cast<uint32_t>(target.height())) {
+        return false;
+    }
+    result.type = static_cast<FrameType>(data[0]);
+    result.version = read_u64(data + 12);
+    result.base_version = read_u64(data + 20);
+    result.tile_count = read_u32(data + 28);
+    const uint8_t *in = data + FrameEncoder::header_size;
+    const uint8_t *end = data + size;
+    if (result.type == FrameType::KEY) {
+        if (static_cast<size_t>(end - in) != target.size()) {
+            return false;
+        }
+        std::memcpy(target.line(0), in, target.size());
+        return true;
+    }
+    const int columns = (target.width() + tile_size - 1) / tile_size;
+    const int rows = (target.height() + tile_size - 1) / tile_size;
+    const auto tiles = static_cast<uint32_t>(columns * rows);
+    for (uint32_t i = 0; i < result.tile_count; i++) {
+        if (end - in < 4) {
+            return false;
+        }
+        const uint32_t index = read_u32(in);
+        in += 4;
+        if (index >= tiles) {
+            return false;
+        }
+        const auto rect = tile_rect(target, tile_size, index);
+        const size_t row_bytes = static_cast<size_t>(rect.x1 - rect.x0) * 4;
+        if (static_cast<size_t>(end - in) < row_bytes * (rect.y1 - rect.y0)) {
+            return false;
+        }
+        for (int y = rect.y0; y < rect.y1; y++) {
+            std::memcpy(target.line(y) + rect.x0 * 4, in, row_bytes);
+            in += row_bytes;
+        }
+    }
+    return in == end;
+}
@@ -0,0 +1,541 @@
+#include "image_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+
+using namespace RenderCore;
+
+namespace {
+
+void append_u32_be(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void write_u32_be(uint8_t *out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+void append_u16_le(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void append_u32_le(std::vector<uint8_t> &out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+// CRC32（PNG 块校验）
+struct Crc32Table {
+    std::array<uint32_t, 256> table{};
+
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    }
+};
+
+uint32_t crc32(const uint8_t *data, size_t size) {
+    static const Crc32Table crc;
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        c = crc.table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+// Adler-32（zlib 校验）
+uint32_t adler32(const uint8_t *data, size_t size) {
+    // 5552 是 b 不溢出 32 位时一次可累加的最大字节数
+    constexpr size_t block = 5552;
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        const size_t n = std::min(size, block);
+        for (size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += n;
+        size -= n;
+    }
+    return (b << 16) | a;
+}
+
+// deflate 固定哈夫曼编码表
+// 码字按位反转后存储，可以直接按低位在前的顺序输出
+struct FixedHuffman {
+    std::array<uint16_t, 288> literal_code{};
+    std::array<uint8_t, 288> literal_bits{};
+    std::array<uint8_t, 30> distance_code{};
+    // 长度 3 ~ 258 对应的长度码（减去 257）
+    std::array<uint8_t, 259> length_symbol{};
+
+    static constexpr std::array<uint16_t, 29> length_base{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15,
+        17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static constexpr std::array<uint8_t, 29> length_extra{
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static constexpr std::array<uint16_t, 30> distance_base{1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33,
+        49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193,
+        12289, 16385, 24577};
+    static constexpr std::array<uint8_t, 30> distance_extra{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4,
+        5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    static uint16_t reverse(uint16_t code, int bits) {
+        uint16_t result = 0;
+        for (int i = 0; i < bits; i++) {
+            result = static_cast<uint16_t>((result << 1) | ((code >> i) & 1));
+        }
+        return result;
+    }
+
+    FixedHuffman() {
+        for (int i = 0; i < 288; i++) {
+            int code, bits;
+            if (i < 144) {
+                code = 0x30 + i, bits = 8;
+            } else if (i < 256) {
+                code = 0x190 + i - 144, bits = 9;
+            } else if (i < 280) {
+                code = i - 256, bits = 7;
+            } else {
+                code = 0xC0 + i - 280, bits = 8;
+            }
+            literal_code[i] = reverse(static_cast<uint16_t>(code), bits);
+            literal_bits[i] = static_cast<uint8_t>(bits);
+        }
+        for (int i = 0; i < 30; i++) {
+            distance_code[i] = static_cast<uint8_t>(reverse(static_cast<uint16_t>(i), 5));
+        }
+        for (int symbol = 0; symbol < 29; symbol++) {
+            const int end = symbol + 1 < 29 ? length_base[symbol + 1] : 259;
+            for (int length = length_base[symbol]; length < end; length++) {
+                length_symbol[length] = static_cast<uint8_t>(symbol);
+            }
+        }
+        // 258 单独使用最后一个长度码
+        length_symbol[258] = 28;
+    }
+
+    static int distance_symbol(uint32_t distance) {
+        const auto it = std::upper_bound(distance_base.begin(), distance_base.end(), distance);
+        return static_cast<int>(it - distance_base.begin()) - 1;
+    }
+};
+
+const FixedHuffman &fixed_huffman() {
+    static const FixedHuffman huffman;
+    return huffman;
+}
+
+constexpr uint32_t window_size = 32768;
+constexpr int hash_bits = 15;
+constexpr uint32_t no_position = 0xFFFFFFFFu;
+constexpr size_t min_match = 4;
+constexpr size_t max_match = 258;
+
+uint32_t read_u32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+uint32_t hash4(const uint8_t *p) { return (read_u32(p) * 2654435761u) >> (32 - hash_bits); }
+
+uint8_t paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return static_cast<uint8_t>(a);
+    }
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+}  // namespace
+
+std::optional<ImageFormat> RenderCore::image_format_from_name(const std::string &name) {
+    if (name == "bmp") {
+        return ImageFormat::BMP;
+    }
+    if (name == "qoi") {
+        return ImageFormat::QOI;
+    }
+    if (name == "png") {
+        return ImageFormat::PNG;
+    }
+    return std::nullopt;
+}
+
+ImageFormat RenderCore::image_format_from_filename(const std::string &filename) {
+    const auto pos = filename.find_last_of('.');
+    if (pos == std::string::npos) {
+        return ImageFormat::BMP;
+    }
+    std::string extension = filename.substr(pos + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return image_format_from_name(extension).value_or(ImageFormat::BMP);
+}
+
+const char *RenderCore::image_mime_type(ImageFormat format) {
+    switch (format) {
+        case ImageFormat::QOI:
+            return "image/qoi";
+        case ImageFormat::PNG:
+            return "image/png";
+        default:
+            return "image/bmp";
+    }
+}
+
+const ImageEncoder::Buffer &ImageEncoder::encode(const Bitmap &bitmap, ImageFormat format) {
+    switch (format) {
+        case ImageFormat::QOI:
+            return encode_qoi(bitmap);
+        case ImageFormat::PNG:
+            return encode_png(bitmap);
+        default:
+            return encode_bmp(bitmap);
+    }
+}
+
+bool ImageEncoder::save(const Bitmap &bitmap, const std::string &filename) {
+    const auto &buffer = encode(bitmap, image_format_from_filename(filename));
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(buffer.data()),
+        static_cast<std::streamsize>(buffer.size()));
+    return static_cast<bool>(file);
+}
+
+const ImageEncoder::Buffer &ImageEncoder::encode_bmp(const Bitmap &bitmap, bool with_alpha) {
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+    const uint32_t pixel_size = with_alpha ? 4 : 3;
+    const uint32_t pitch = (width * pixel_size + 3) & (~3);
+    constexpr uint32_t info_header_size = 40;
+    const uint32_t offset = 14 + info_header_size;
+    buffer_.clear();
+    buffer_.reserve(offset + pitch * height);
+    buffer_.push_back('B');
+    buffer_.push_back('M');
+    append_u32_le(buffer_, offset + pitch * height);
+    append_u32_le(buffer_, 0);
+    append_u32_le(buffer_, offset);
+    append_u32_le(buffer_, info_header_size);
+    append_u32_le(buffer_, static_cast<uint32_t>(width));
+    append_u32_le(buffer_, static_cast<uint32_t>(height));
+    append_u16_le(buffer_, 1);
+    append_u16_le(buffer_, static_cast<uint16_t>(pixel_size * 8));
+    append_u32_le(buffer_, 0);
+    append_u32_le(buffer_, pitch * height);
+    for (int i = 0; i < 4; i++) {
+        append_u32_le(buffer_, 0);
+    }
+    // bmp文件是从下到上、BGRA顺序保存的
+    const size_t header_size = buffer_.size();
+    buffer_.resize(header_size + static_cast<size_t>(pitch) * height);
+    uint8_t *out = buffer_.data() + header_size;
+    for (int i = 0; i < height; i++) {
+        const uint8_t *line = bitmap.line(height - i - 1);
+        uint8_t *row = out + static_cast<size_t>(pitch) * i;
+        for (int j = 0; j < width; j++) {
+            row[0] = line[2];
+            row[1] = line[1];
+            row[2] = line[0];
+            if (with_alpha) {
+                row[3] = line[3];
+            }
+            row += pixel_size;
+            line += 4;
+        }
+        std::fill(row, out + static_cast<size_t>(pitch) * (i + 1), 0);
+    }
+    return buffer_;
+}
+
+const ImageEncoder::Buffer &ImageEncoder::encode_qoi(const Bitmap &bitmap) {
+    // 格式见 https://qoiformat.org/qoi-specification.pdf
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+    const size_t pixel_count = static_cast<size_t>(width) * height;
+    // 最坏情况下每个像素 5 字节
+    buffer_.resize(14 + pixel_count * 5 + 8);
+    uint8_t *out = buffer_.data();
+    std::memcpy(out, "qoif", 4);
+    write_u32_be(out + 4, static_cast<uint32_t>(width));
+    write_u32_be(out + 8, static_cast<uint32_t>(height));
+    out[12] = 4;  // RGBA
+    out[13] = 0;  // sRGB，alpha 不预乘
+    out += 14;
+
+    std::array<uint32_t, 64> index{};
+    // 像素按 RGBA 字节顺序存储，小端序读取时 r 在低位
+    uint8_t prev[4] = {0, 0, 0, 255};
+    uint32_t prev_value = 0xFF000000u;
+    int run = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *line = bitmap.line(y);
+        for (int x = 0; x < width; x++, line += 4) {
+            const uint32_t value = static_cast<uint32_t>(line[0]) | (line[1] << 8) |
+                                   (line[2] << 16) | (static_cast<uint32_t>(line[3]) << 24);
+            if (value == prev_value) {
+                run++;
+                if (run == 62) {
+                    *out++ = static_cast<uint8_t>(0xC0 | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *out++ = static_cast<uint8_t>(0xC0 | (run - 1));
+                run = 0;
+            }
+            const int hash = (line[0] * 3 + line[1] * 5 + line[2] * 7 + line[3] * 11) % 64;
+            if (index[hash] == value) {
+                *out++ = static_cast<uint8_t>(hash);
+            } else {
+                index[hash] = value;
+                if (line[3] == prev[3]) {
+                    const auto vr = static_cast<int8_t>(line[0] - prev[0]);
+                    const auto vg = static_cast<int8_t>(line[1] - prev[1]);
+                    const auto vb = static_cast<int8_t>(line[2] - prev[2]);
+                    const int vg_r = vr - vg;
+                    const int vg_b = vb - vg;
+                    if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1) {
+                        *out++ = static_cast<uint8_t>(
+                            0x40 | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+                    } else if (vg_r >= -8 && vg_r <= 7 && vg >= -32 && vg <= 31 && vg_b >= -8 &&
+                               vg_b <= 7) {
+                        *out++ = static_cast<uint8_t>(0x80 | (vg + 32));
+                        *out++ = static_cast<uint8_t>(((vg_r + 8) << 4) | (vg_b + 8));
+                    } else {
+                        *out++ = 0xFE;
+                        *out++ = line[0];
+                        *out++ = line[1];
+                        *out++ = line[2];
+                    }
+                } else {
+                    *out++ = 0xFF;
+                    std::memcpy(out, line, 4);
+                    out += 4;
+                }
+            }
+            std::memcpy(prev, line, 4);
+            prev_value = value;
+        }
+    }
+    if (run > 0) {
+        *out++ = static_cast<uint8_t>(0xC0 | (run - 1));
+    }
+    static constexpr uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    std::memcpy(out, padding, 8);
+    out += 8;
+    buffer_.resize(out - buffer_.data());
+    return buffer_;
+}
+
+const ImageEncoder::Buffer &ImageEncoder::encode_png(const Bitmap &bitmap) {
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+    const size_t row_bytes = static_cast<size_t>(width) * 4;
+
+    // 行过滤，每行前加过滤方式字节
+    filtered_.resize((row_bytes + 1) * height);
+    const auto filter = png_options_.filter;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *line = bitmap.line(y);
+        const uint8_t *prior = y > 0 ? bitmap.line(y - 1) : nullptr;
+        uint8_t *out = filtered_.data() + (row_bytes + 1) * y;
+        *out++ = static_cast<uint8_t>(filter);
+        switch (filter) {
+            case PngFilter::SUB:
+                std::memcpy(out, line, 4);
+                for (size_t i = 4; i < row_bytes; i++) {
+                    out[i] = static_cast<uint8_t>(line[i] - line[i - 4]);
+                }
+                break;
+            case PngFilter::UP:
+                for (size_t i = 0; i < row_bytes; i++) {
+                    out[i] = static_cast<uint8_t>(line[i] - (prior ? prior[i] : 0));
+                }
+                break;
+            case PngFilter::PAETH:
+                for (size_t i = 0; i < row_bytes; i++) {
+                    const int a = i >= 4 ? line[i - 4] : 0;
+                    const int b = prior ? prior[i] : 0;
+                    const int c = prior && i >= 4 ? prior[i - 4] : 0;
+                    out[i] = static_cast<uint8_t>(line[i] - paeth(a, b, c));
+                }
+                break;
+            default:
+                std::memcpy(out, line, row_bytes);
+                break;
+        }
+    }
+
+    buffer_.clear();
+    static constexpr uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    buffer_.insert(buffer_.end(), signature, signature + 8);
+    // 写入块，数据已追加在 start + 8 之后
+    const auto finish_chunk = [this](size_t start) {
+        const auto length = static_cast<uint32_t>(buffer_.size() - start - 8);
+        write_u32_be(buffer_.data() + start, length);
+        append_u32_be(buffer_, crc32(buffer_.data() + start + 4, length + 4));
+    };
+    const auto begin_chunk = [this](const char *type) {
+        const size_t start = buffer_.size();
+        append_u32_be(buffer_, 0);
+        buffer_.insert(buffer_.end(), type, type + 4);
+        return start;
+    };
+
+    auto start = begin_chunk("IHDR");
+    append_u32_be(buffer_, static_cast<uint32_t>(width));
+    append_u32_be(buffer_, static_cast<uint32_t>(height));
+    buffer_.push_back(8);  // 位深度
+    buffer_.push_back(6);  // RGBA
+    buffer_.push_back(0);  // 压缩方式
+    buffer_.push_back(0);  // 过滤方式
+    buffer_.push_back(0);  // 不隔行
+    finish_chunk(start);
+
+    start = begin_chunk("IDAT");
+    deflate(filtered_.data(), filtered_.size());
+    finish_chunk(start);
+
+    start = begin_chunk("IEND");
+    finish_chunk(start);
+    return buffer_;
+}
+
+void ImageEncoder::deflate(const uint8_t *data, size_t size) {
+    // zlib 头：32K 窗口，deflate
+    buffer_.push_back(0x78);
+    buffer_.push_back(0x01);
+    if (png_options_.level <= 0) {
+        deflate_stored(data, size);
+    } else {
+        deflate_fixed(data, size);
+    }
+    append_u32_be(buffer_, adler32(data, size));
+}
+
+void ImageEncoder::deflate_stored(const uint8_t *data, size_t size) {
+    do {
+        const auto length = static_cast<uint16_t>(std::min<size_t>(size, 65535));
+        const bool final = length == size;
+        buffer_.push_back(final ? 1 : 0);
+        append_u16_le(buffer_, length);
+        append_u16_le(buffer_, static_cast<uint16_t>(~length));
+        buffer_.insert(buffer_.end(), data, data + length);
+        data += length;
+        size -= length;
+    } while (size > 0);
+}
+
+void ImageEncoder::put_bits(uint32_t value, int count) {
+    bits_ |= static_cast<uint64_t>(value) << bit_count_;
+    bit_count_ += count;
+    if (bit_count_ >= 32) {
+        append_u32_le(buffer_, static_cast<uint32_t>(bits_));
+        bits_ >>= 32;
+        bit_count_ -= 32;
+    }
+}
+
+void ImageEncoder::flush_bits() {
+    while (bit_count_ > 0) {
+        buffer_.push_back(static_cast<uint8_t>(bits_));
+        bits_ >>= 8;
+        bit_count_ -= 8;
+    }
+    bits_ = 0;
+    bit_count_ = 0;
+}
+
+void ImageEncoder::deflate_fixed(const uint8_t *data, size_t size) {
+    // 单个固定哈夫曼块，贪心匹配
+    // 只在匹配的起点插入哈希表，匹配内部的位置不插入，以速度换取少量压缩率
+    const auto &huffman = fixed_huffman();
+    const int max_chain = std::min(png_options_.level, 9);
+    head_.assign(size_t{1} << hash_bits, no_position);
+    prev_.resize(window_size);
+
+    bits_ = 0;
+    bit_count_ = 0;
+    put_bits(1, 1);  // BFINAL
+    put_bits(1, 2);  // BTYPE = 01
+
+    size_t pos = 0;
+    while (pos < size) {
+        size_t best_length = 0;
+        uint32_t best_distance = 0;
+        if (pos + min_match <= size) {
+            const uint32_t hash = hash4(data + pos);
+            const size_t limit = std::min(max_match, size - pos);
+            uint32_t candidate = head_[hash];
+            for (int chain = 0; chain < max_chain && candidate != no_position &&
+                                pos - candidate <= window_size;
+                 chain++) {
+                const uint8_t *a = data + candidate;
+                const uint8_t *b = data + pos;
+                if (a[best_length] == b[best_length] || best_length == 0) {
+                    size_t length = 0;
+                    while (length < limit && a[length] == b[length]) {
+                        length++;
+                    }
+                    if (length > best_length) {
+                        best_length = length;
+                        best_distance = static_cast<uint32_t>(pos - candidate);
+                        if (length == limit) {
+                            break;
+                        }
+                    }
+                }
+                const uint32_t next = prev_[candidate % window_size];
+                // 链表中的位置被更新的位置覆盖时停止
+                if (next == no_position || next >= candidate) {
+                    break;
+                }
+                candidate = next;
+            }
+            prev_[pos % window_size] = head_[hash];
+            head_[hash] = static_cast<uint32_t>(pos);
+        }
+        if (best_length >= min_match) {
+            const int length_symbol = huffman.length_symbol[best_length];
+            put_bits(huffman.literal_code[257 + length_symbol],
+                huffman.literal_bits[257 + length_symbol]);
+            put_bits(static_cast<uint32_t>(best_length - FixedHuffman::length_base[length_symbol]),
+                FixedHuffman::length_extra[length_symbol]);
+            const int distance_symbol = FixedHuffman::distance_symbol(best_distance);
+            put_bits(huffman.distance_code[distance_symbol], 5);
+            put_bits(best_distance - FixedHuffman::distance_base[distance_symbol],
+                FixedHuffman::distance_extra[distance_symbol]);
+            pos += best_length;
+        } else {
+            put_bits(huffman.literal_code[data[pos]], huffman.literal_bits[data[pos]]);
+            pos++;
+        }
+    }
+    put_bits(huffman.literal_code[256], huffman.literal_bits[256]);
+    flush_bits();
+}
@@ -11,19 +11,68 @@
 
 using namespace RenderCore;
 
+namespace {
+
+// 向下取整的除法，b > 0
+int64_t floor_div(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// 向上取整的除法，b > 0
+int64_t ceil_div(int64_t a, int64_t b) {
+    return -floor_div(-a, b);
+}
+
+}  // namespace
+
+std::pair<int64_t, int64_t> LineStepper::clip(
+    const Bounds &bounds, int64_t first, int64_t last) const {
+    // 坐标落在 [lo, hi) 内时，沿方向 s 相对 origin 的偏移范围
+    const auto offsets = [](int origin, int s, int lo, int hi) {
+        if (s > 0) {
+            return std::pair<int64_t, int64_t>{int64_t{lo} - origin, int64_t{hi} - 1 - origin};
+        }
+        return std::pair<int64_t, int64_t>{int64_t{origin} - hi + 1, int64_t{origin} - lo};
+    };
+    const auto x_range = offsets(start.x, sx, bounds.min_x, bounds.max_x);
+    const auto y_range = offsets(start.y, sy, bounds.min_y, bounds.max_y);
+    const auto [major_lo, major_hi] = x_major ? x_range : y_range;
+    const auto [minor_lo, minor_hi] = x_major ? y_range : x_range;
+    // 主方向的偏移就是步数
+    first = max(first, major_lo);
+    last = min(last, major_hi);
+    // 次方向的偏移 moves(k) 随步数单调不减，反解出步数的范围
+    if (minor == 0) {
+        if (minor_lo > 0 || minor_hi < 0) {
+            return {1, 0};
+        }
+    } else {
+        // moves(k) >= minor_lo 即 2k * minor + bias >= 2 * major * minor_lo
+        first = max(first, ceil_div(2 * major * minor_lo - bias, 2 * minor));
+        // moves(k) <= minor_hi 即 2k * minor + bias < 2 * major * (minor_hi + 1)
+        last = min(last, floor_div(2 * major * (minor_hi + 1) - bias - 1, 2 * minor));
+    }
+    return {first, last};
+}
+
 void RenderEngine::draw_line_dda(const Point &p1, const Point &p2) {
     int x1 = p1.x, y1 = p1.y;
     int x2 = p2.x, y2 = p2.y;
 
+    // 浮点累加的结果无法直接求出，绘制区域之前的部分只累加不绘制，之后的部分不再遍历
     float k = (float)(y2 - y1) / (float)(x2 - x1);
     if (abs(k) <= 1) {
         if (x1 > x2) {
             std::swap(x1, x2);
             std::swap(y1, y2);
         }
+        const int first = max(x1, scissor_.min_x);
+        const int last = min(x2, scissor_.max_x - 1);
         auto y = (float)y1;
-        for (int x = x1, index = 0; x <= x2; ++x) {
-            draw_point(x, (int)round(y), index++);
+        for (int x = x1, index = 0; x <= last; ++x, ++index) {
+            if (x >= first) {
+                draw_point(x, (int)round(y), index);
+            }
             y += k;
         }
     } else {
@@ -31,10 +80,14 @@ void RenderEngine::draw_line_dda(const Point &p1, const Point &p2) {
             std::swap(x1, x2);
             std::swap(y1, y2);
         }
+        const int first = max(y1, scissor_.min_y);
+        const int last = min(y2, scissor_.max_y - 1);
         k = 1 / k;
         auto x = (float)x1;
-        for (int y = y1, index = 0; y <= y2; ++y) {
-            draw_point((int)round(x), y, index++);
+        for (int y = y1, index = 0; y <= last; ++y, ++index) {
+            if (y >= first) {
+                draw_point((int)round(x), y, index);
+            }
             x += k;
         }
     }
@@ -53,66 +106,86 @@ void RenderEngine::draw_line_midpoint(const Point &p1, const Point &p2) {
     dx = abs(dx);
     dy = abs(dy);
 
-    int index = 0;
-    // 选择主要的增量方向
-    if (dx > dy) {
-        // 主要沿 x 方向
-        int d = 2 * dy - dx;  // 初始决策参数
-        for (int x = x1, y = y1; x != x2; x += sx) {
-            draw_point(x, y, index++);  // 绘制当前像素
+    // 选择主要的增量方向，dx > dy 时主要沿 x 方向，否则主要沿 y 方向
+    const bool x_major = dx > dy;
+    const int64_t major = x_major ? dx : dy;
+    const int64_t minor = x_major ? dy : dx;
+    const LineStepper stepper{p1, sx, sy, x_major, major, minor, major - 1};
+    // 沿主方向共 major 步（不含终点），只绘制落在绘制区域内的步
+    const auto [first, last] = stepper.clip(scissor_, 0, major - 1);
+    if (first <= last) {
+        const auto start = stepper.at(first);
+        int x = start.x, y = start.y;
+        // 第 first 步的决策参数
+        int64_t d = 2 * minor - major + 2 * first * minor - 2 * stepper.moves(first) * major;
+        for (int64_t index = first; index <= last; index++) {
+            draw_point(x, y, static_cast<int>(index));  // 绘制当前像素
             if (d > 0) {
-                y += sy;      // 更新 y 坐标
-                d -= 2 * dx;  // 更新决策参数
+                // 更新次方向坐标和决策参数
+                if (x_major) {
+                    y += sy;
+                } else {
+                    x += sx;
+                }
+                d -= 2 * major;
             }
-            d += 2 * dy;  // 更新决策参数
-        }
-    } else {
-        // 主要沿 y 方向
-        int d = 2 * dx - dy;  // 初始决策参数
-        for (int y = y1, x = x1; y != y2; y += sy) {
-            draw_point(x, y, index++);  // 绘制当前像素
-            if (d > 0) {
-                x += sx;      // 更新 x 坐标
-                d -= 2 * dy;  // 更新决策参数
+            d += 2 * minor;  // 更新决策参数
+            if (x_major) {
+                x += sx;
+            } else {
+                y += sy;
             }
-            d += 2 * dx;  // 更新决策参数
         }
     }
 
     // 绘制终点
-    draw_point(x1, y1, index);
+    draw_point(x1, y1, static_cast<int>(major));
 }
 
 void RenderEngine::draw_line_bresenham(const Point &p1, const Point &p2) {
-    int x1 = p1.x, y1 = p1.y;
-    int x2 = p2.x, y2 = p2.y;
-
-    int dx = abs(x2 - x1);
-    int dy = abs(y2 - y1);
-    int sx = (x1 < x2) ? 1 : -1;
-    int sy = (y1 < y2) ? 1 : -1;
-    int err = dx - dy;
-
-    int index = 0;
+    const int64_t dx = abs(int64_t{p2.x} - p1.x);
+    const int64_t dy = abs(int64_t{p2.y} - p1.y);
+    const int sx = (p1.x < p2.x) ? 1 : -1;
+    const int sy = (p1.y < p2.y) ? 1 : -1;
+
+    // 第 k 步的像素线型下标为 k，只绘制落在绘制区域内的步
+    const bool x_major = dx >= dy;
+    const int64_t major = x_major ? dx : dy;
+    const LineStepper stepper{p1, sx, sy, x_major, major, x_major ? dy : dx, major - 1};
+    const auto [first, last] = stepper.clip(scissor_, 0, major);
+    if (first > last) {
+        return;
+    }
+    // 第 first 步的误差项：初值 dx - dy，x 每移动一次减 dy，y 每移动一次加 dx
+    const auto moves = stepper.moves(first);
+    const auto start = stepper.at(first);
+    int x = start.x, y = start.y;
+    int64_t err = dx - dy - (x_major ? first : moves) * dy + (x_major ? moves : first) * dx;
 
-    while (true) {
-        draw_point(x1, y1, index++);
+    for (int64_t index = first;; index++) {
+        draw_point(x, y, static_cast<int>(index));
 
-        if (x1 == x2 && y1 == y2) break;
+        if (index == last) break;
 
-        int e2 = 2 * err;
+        const int64_t e2 = 2 * err;
         if (e2 > -dy) {
             err -= dy;
-            x1 += sx;
+            x += sx;
         }
         if (e2 < dx) {
             err += dx;
-            y1 += sy;
+            y += sy;
         }
     }
 }
 
 void RenderEngine::draw_line(const Line &line) {
+    // 线宽大于 1 时沿线段的轮廓描边
+    if (pen_options_.width > 1) {
+        const Point points[] = {line.p1, line.p2};
+        draw_stroke(points, false);
+        return;
+    }
     // 画特殊斜率的线段
     if (line.p1 == line.p2) {
         draw_point(line.p1.x, line.p1.y, 0);
@@ -121,16 +194,30 @@ void RenderEngine::draw_line(const Line &line) {
         int y1 = min(line.p1.y, line.p2.y);
         int y2 = max(line.p1.y, line.p2.y);
         int x = line.p1.x;
-        for (int y = y1, index = 0; y <= y2; ++y) {
-            draw_point(x, y, index++);
+        // 只遍历绘制区域内的部分，线型下标从 y1 开始计数
+        if (x < scissor_.min_x || x >= scissor_.max_x) {
+            return;
+        }
+        const int last = min(y2, scissor_.max_y - 1);
+        for (int y = max(y1, scissor_.min_y); y <= last; ++y) {
+            draw_point(x, y, y - y1);
         }
         return;
     } else if (line.p1.y == line.p2.y) {
         int x1 = min(line.p1.x, line.p2.x);
         int x2 = max(line.p1.x, line.p2.x);
         int y = line.p1.y;
-        for (int x = x1, index = 0; x <= x2; ++x) {
-            draw_point(x, y, index++);
+        // 实线按行绘制
+        if (pen_options_.type == PenOptions::LineType::SOLID) {
+            draw_span(y, x1, x2 + 1, pen_options_.color);
+            return;
+        }
+        if (y < scissor_.min_y || y >= scissor_.max_y) {
+            return;
+        }
+        const int last = min(x2, scissor_.max_x - 1);
+        for (int x = max(x1, scissor_.min_x); x <= last; ++x) {
+            draw_point(x, y, x - x1);
         }
         return;
     }
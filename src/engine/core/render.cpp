@@ -0,0 +1,657 @@
+#include <cmath>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+#include "engine.hpp"
+#include "stroke.hpp"
+#include "utils.hpp"
+
+using namespace RenderCore;
+
+extern std::pair<Point, int> circle_center_radius(
+    const Point &p1, const Point &p2, const Point &p3);
+
+bool RenderEngine::render() {
+    if (!frame_buffer_) {
+        return false;
+    }
+    if (!take_edits()) {
+        return true;
+    }
+    sync_tile_engines();
+    geometry_cache_.validate(global_options_);
+    if (!full_redraw_) {
+        // 被修改、插入的图元的新包围盒也需要重绘
+        for (const auto index : prepare_render_items(0)) {
+            add_dirty_region(render_items_[index].bounds);
+        }
+        // 种子填充的结果依赖整帧内容，无法只重绘局部区域
+        if (!dirty_regions_.empty()) {
+            for (const auto &item : render_items_) {
+                if (item.barrier) {
+                    full_redraw_ = true;
+                    break;
+                }
+            }
+        }
+    }
+    acquire_frame_buffer();
+    if (full_redraw_) {
+        render_items_.clear();
+        dirty_regions_.clear();
+        tail_pen_options_ = {};
+        tail_transform_matrix_ = Matrix3f::identity();
+        fill_with_background_color();
+    } else {
+        redraw_dirty_regions();
+    }
+    // 追加的图元直接绘制在已有的画面上
+    const auto begin = render_items_.size();
+    append_render_items();
+    rasterize_items(begin, render_items_.size(), frame_bounds());
+    full_redraw_ = false;
+    primitives_.reset();
+    geometry_cache_.collect();
+    // 本轮的临时内存整体释放
+    render_arena_.reset();
+    for (auto &tile_engine : tile_engines_) {
+        tile_engine->render_arena_.reset();
+    }
+    frame_version_++;
+    return true;
+}
+
+void RenderEngine::sync_tile_engines() {
+    for (auto &tile_engine : tile_engines_) {
+        tile_engine->width_ = width_;
+        tile_engine->height_ = height_;
+        tile_engine->global_options_ = global_options_;
+    }
+}
+
+bool RenderEngine::take_edits() {
+    {
+        std::lock_guard lock(edit_mutex_);
+        if (!edit_.need_render) {
+            return false;
+        }
+        primitives_ = publish_snapshot();
+        global_options_ = edit_.global_options;
+        full_redraw_ = full_redraw_ || edit_.full_redraw;
+        pending_edits_.clear();
+        pending_edits_.swap(edit_.edits);
+        edit_.full_redraw = false;
+        edit_.need_render = false;
+    }
+    // 编辑记录在锁外应用，编辑接口不必等待
+    for (const auto &edit : pending_edits_) {
+        if (full_redraw_) {
+            break;
+        }
+        apply_edit(edit);
+    }
+    return true;
+}
+
+void RenderEngine::apply_edit(const PrimitiveEdit &edit) {
+    // 编辑尚未绘制的图元不影响已有的渲染项
+    if (edit.index >= render_items_.size()) {
+        return;
+    }
+    const auto index = static_cast<std::ptrdiff_t>(edit.index);
+    auto &item = render_items_[edit.index];
+    switch (edit.type) {
+        case PrimitiveEdit::Type::INSERT:
+            // 插入的图元会改变后续图元的状态，或插入位置处于变换的作用范围内时，重绘整帧
+            if (edit.state || item.transform_matrix != Matrix3f::identity()) {
+                full_redraw_ = true;
+            } else {
+                RenderItem inserted;
+                inserted.pen_options =
+                    edit.index > 0 ? render_items_[edit.index - 1].pen_options : PenOptions{};
+                inserted.dirty = true;
+                render_items_.insert(render_items_.begin() + index, std::move(inserted));
+            }
+            break;
+        case PrimitiveEdit::Type::REMOVE:
+            // 删除状态图元，或删除的图元处于变换的作用范围内（变换会转移到下一个图元）时，重绘整帧
+            if (edit.state || item.transform_matrix != Matrix3f::identity()) {
+                full_redraw_ = true;
+            } else {
+                add_dirty_region(item.bounds);
+                render_items_.erase(render_items_.begin() + index);
+            }
+            break;
+        case PrimitiveEdit::Type::MODIFY:
+            if (edit.state) {
+                full_redraw_ = true;
+            } else {
+                // 旧图元覆盖的区域需要重绘，新图元的包围盒在渲染时计算
+                add_dirty_region(item.bounds);
+                item.dirty = true;
+            }
+            break;
+    }
+}
+
+void RenderEngine::acquire_frame_buffer() {
+    if (!frame_buffer_ || frame_buffer_.use_count() == 1) {
+        return;
+    }
+    // 快照只能由渲染线程通过 get_frame() 取得，引用计数为 1 的缓冲区不会再被其他线程引用
+    std::shared_ptr<Bitmap> buffer;
+    for (auto it = frame_pool_.begin(); it != frame_pool_.end(); ++it) {
+        if (it->use_count() == 1) {
+            buffer = std::move(*it);
+            frame_pool_.erase(it);
+            break;
+        }
+    }
+    if (!buffer) {
+        buffer = std::make_shared<Bitmap>(width_, height_);
+    }
+    // 增量渲染在上一帧的基础上绘制
+    if (!full_redraw_) {
+        buffer->copy_from(*frame_buffer_);
+    }
+    frame_pool_.push_back(std::move(frame_buffer_));
+    frame_buffer_ = std::move(buffer);
+    // 超出数量的旧缓冲区交给快照持有者释放
+    if (frame_pool_.size() >= frame_buffer_count) {
+        frame_pool_.erase(frame_pool_.begin());
+    }
+}
+
+void RenderEngine::append_render_items() {
+    // 从上次渲染结束时的状态继续
+    pen_options_ = tail_pen_options_;
+    transform_matrix_ = tail_transform_matrix_;
+
+    const auto begin = render_items_.size();
+    const auto &primitives = *primitives_;
+    render_items_.reserve(primitives.size());
+    for (auto it = primitives.iterator_at(begin); it != primitives.end(); ++it) {
+        const auto &primitive = *it;
+        // 记录绘制时的状态
+        // 画笔选项会影响接下来的图元直到下一个画笔选项
+        if (std::holds_alternative<PenOptions>(primitive)) {
+            pen_options_ = std::get<PenOptions>(primitive);
+        }
+        auto &item = render_items_.emplace_back();
+        item.pen_options = pen_options_;
+        item.transform_matrix = transform_matrix_;
+        item.dirty = true;
+        // 变换矩阵只对下一个图元有效
+        if (std::holds_alternative<Transform>(primitive)) {
+            make_transform(std::get<Transform>(primitive));
+        } else if (!std::holds_alternative<PenOptions>(primitive)) {
+            transform_matrix_ = Matrix3f::identity();
+        }
+    }
+    tail_pen_options_ = pen_options_;
+    tail_transform_matrix_ = transform_matrix_;
+
+    prepare_render_items(begin);
+}
+
+std::vector<size_t> RenderEngine::prepare_render_items(size_t begin) {
+    std::vector<size_t> indices;
+    for (size_t i = begin; i < render_items_.size(); i++) {
+        if (render_items_[i].dirty) {
+            indices.push_back(i);
+        }
+    }
+    // 派生几何先在缓存中查找，只有未命中的渲染项需要重新变换、裁剪和采样
+    std::vector<std::pair<size_t, GeometryCache::Key>> misses;
+    for (const auto index : indices) {
+        auto &item = render_items_[index];
+        const auto &primitive = (*primitives_)[index];
+        item.geometry.reset();
+        if (!has_derived_geometry(item, primitive)) {
+            continue;
+        }
+        auto key = GeometryCache::make_key(primitive, item.transform_matrix);
+        item.geometry = geometry_cache_.find(key);
+        if (!item.geometry) {
+            misses.emplace_back(index, std::move(key));
+        }
+    }
+    // 每个渲染项只依赖自身记录的状态，可以并行准备
+    // 并行时使用各线程的绘制上下文，裁剪、采样的临时内存从线程自己的内存池分配
+    const auto prepare = [&](size_t index, size_t thread_index) {
+        auto &item = render_items_[indices[index]];
+        auto &engine = thread_pool_ ? *tile_engines_[thread_index] : *this;
+        engine.prepare_render_item(item, (*primitives_)[indices[index]]);
+        item.dirty = false;
+    };
+    if (thread_pool_) {
+        thread_pool_->parallel_for(indices.size(), prepare);
+    } else {
+        for (size_t i = 0; i < indices.size(); i++) {
+            prepare(i, 0);
+        }
+    }
+    for (auto &[index, key] : misses) {
+        geometry_cache_.insert(std::move(key), render_items_[index].geometry);
+    }
+    return indices;
+}
+
+bool RenderEngine::has_derived_geometry(const RenderItem &item, const Primitive &primitive) const {
+    return std::visit(
+        [&](const auto &prim) {
+            using T = std::decay_t<decltype(prim)>;
+            // 有变换矩阵的可绘制图元
+            if constexpr (!std::is_same_v<T, PenOptions> && !std::is_same_v<T, Transform> &&
+                          !std::is_same_v<T, std::monostate>) {
+                if (item.transform_matrix != Matrix3f::identity()) {
+                    return true;
+                }
+            }
+            // 只有线段、矩形、多边形会被裁剪
+            if constexpr (std::is_same_v<T, Line> || std::is_same_v<T, Rectangle>) {
+                return global_options_.clip.enable;
+            } else if constexpr (std::is_same_v<T, Polygon>) {
+                // 多边形的凸性只判断一次
+                return true;
+            } else if constexpr (std::is_same_v<T, Circle>) {
+                // 三点确定的圆预先求出圆心和半径
+                return std::holds_alternative<CircleUseThreePoints>(prim);
+            } else {
+                // 曲线需要采样
+                return std::is_same_v<T, BezierCurve> || std::is_same_v<T, BsplineCurve>;
+            }
+        },
+        primitive);
+}
+
+std::shared_ptr<const DerivedGeometry> RenderEngine::derive_geometry(
+    const RenderItem &item, const Primitive &primitive) {
+    auto geometry = std::make_shared<DerivedGeometry>();
+    // 应用变换矩阵
+    // 变换在栅格化前作用于图元的几何，矩形、圆、圆弧、椭圆可能换成等价的其他图元
+    if (item.transform_matrix != Matrix3f::identity() ||
+        std::holds_alternative<Circle>(primitive)) {
+        geometry->modified = primitive;
+        apply_transform_matrix(*geometry->modified, item.transform_matrix);
+    }
+    // 裁剪
+    // 只有线段、矩形、多边形会被裁剪，裁剪后的图元会替换副本，可能是空的 monostate
+    const auto &transformed = geometry->modified ? *geometry->modified : primitive;
+    if (global_options_.clip.enable && (std::holds_alternative<Line>(transformed) ||
+                                           std::holds_alternative<Rectangle>(transformed) ||
+                                           std::holds_alternative<Polygon>(transformed))) {
+        if (!geometry->modified) {
+            geometry->modified = primitive;
+        }
+        clip(*geometry->modified);
+    }
+    // 三点确定的圆转换为圆心和半径，绘制和计算包围盒时不必再求
+    if (geometry->modified && std::holds_alternative<Circle>(*geometry->modified)) {
+        if (const auto *circle =
+                std::get_if<CircleUseThreePoints>(&std::get<Circle>(*geometry->modified))) {
+            auto [center, radius] = circle_center_radius(circle->p1, circle->p2, circle->p3);
+            geometry->modified = Circle{CircleUseCenterRadius{center, radius}};
+        }
+    }
+    const auto &result = geometry->modified ? *geometry->modified : primitive;
+    // 判断多边形的凸性
+    if (std::holds_alternative<Polygon>(result)) {
+        geometry->convex = is_convex_polygon(std::get<Polygon>(result));
+    }
+    // 曲线采样
+    if (std::holds_alternative<BezierCurve>(result)) {
+        sample_bezier_curve(std::get<BezierCurve>(result), geometry->samples);
+    } else if (std::holds_alternative<BsplineCurve>(result)) {
+        sample_bspline_curve(std::get<BsplineCurve>(result), geometry->samples);
+    }
+    chunk_curve_samples(geometry->samples, geometry->chunks);
+    return geometry;
+}
+
+void RenderEngine::prepare_render_item(RenderItem &item, const Primitive &primitive) {
+    // 派生几何在缓存中未命中时重新计算
+    if (!has_derived_geometry(item, primitive)) {
+        item.geometry.reset();
+    } else if (!item.geometry) {
+        item.geometry = derive_geometry(item, primitive);
+    }
+    const auto &result =
+        item.geometry && item.geometry->modified ? *item.geometry->modified : primitive;
+    item.barrier = std::holds_alternative<Fill>(result);
+    item.bounds = render_item_bounds(item, result);
+}
+
+void RenderEngine::add_dirty_region(const Bounds &region) {
+    auto merged = bounds_intersect(region, frame_bounds());
+    if (merged.empty()) {
+        return;
+    }
+    // 与相交的区域合并，合并后可能与之前检查过的区域相交，需要重新检查
+    for (size_t i = 0; i < dirty_regions_.size();) {
+        if (bounds_overlap(dirty_regions_[i], merged)) {
+            merged = bounds_union(dirty_regions_[i], merged);
+            dirty_regions_.erase(dirty_regions_.begin() + static_cast<std::ptrdiff_t>(i));
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    dirty_regions_.push_back(merged);
+    // 区域过多时每个区域都要遍历一次渲染项，合并为一个区域
+    if (dirty_regions_.size() > max_dirty_regions) {
+        Bounds bounds{};
+        for (const auto &dirty_region : dirty_regions_) {
+            bounds = bounds_union(bounds, dirty_region);
+        }
+        dirty_regions_ = {bounds};
+    }
+}
+
+void RenderEngine::redraw_dirty_regions() {
+    if (dirty_regions_.empty()) {
+        return;
+    }
+    // 脏区域超过画布一半时，直接重绘整帧
+    int64_t area = 0;
+    for (const auto &region : dirty_regions_) {
+        area += static_cast<int64_t>(region.width()) * region.height();
+    }
+    if (area * 2 > static_cast<int64_t>(width_) * height_) {
+        dirty_regions_ = {frame_bounds()};
+    }
+    const auto color = vector_to_color(global_options_.background_color);
+    for (const auto &region : dirty_regions_) {
+        frame_buffer_->fill(color, region.min_x, region.min_y, region.max_x, region.max_y);
+        rasterize_items(0, render_items_.size(), region);
+    }
+    dirty_regions_.clear();
+}
+
+Bounds RenderEngine::render_item_bounds(const RenderItem &item, const Primitive &primitive) const {
+    // 点集的包围盒
+    const auto points_bounds = [](std::initializer_list<Point> points) {
+        Bounds bounds{points.begin()->x, points.begin()->y, points.begin()->x + 1,
+            points.begin()->y + 1};
+        for (const auto &point : points) {
+            bounds = bounds_union(bounds, make_bounds(point.x, point.y, point.x + 1, point.y + 1));
+        }
+        return bounds;
+    };
+    const auto vector_bounds = [](const std::vector<Point> &points) {
+        Bounds bounds{};
+        for (const auto &point : points) {
+            bounds = bounds_union(bounds, make_bounds(point.x, point.y, point.x + 1, point.y + 1));
+        }
+        return bounds;
+    };
+    const auto circle_bounds = [](const Point &center, int radius) {
+        // 三点共线时圆心和半径可能非常大，限制范围防止溢出
+        constexpr int limit = 1 << 28;
+        radius = min(abs(radius), limit);
+        const int x = clamp(center.x, -limit, limit);
+        const int y = clamp(center.y, -limit, limit);
+        return make_bounds(x - radius, y - radius, x + radius + 1, y + radius + 1);
+    };
+
+    const auto frame = frame_bounds();
+    const auto bounds = std::visit(
+        [&](const auto &prim) -> Bounds {
+            using T = std::decay_t<decltype(prim)>;
+            if constexpr (std::is_same_v<T, Line>) {
+                return points_bounds({prim.p1, prim.p2});
+            } else if constexpr (std::is_same_v<T, Circle>) {
+                if (std::holds_alternative<CircleUseCenterRadius>(prim)) {
+                    const auto &circle = std::get<CircleUseCenterRadius>(prim);
+                    return circle_bounds(circle.center, circle.radius);
+                }
+                const auto &circle = std::get<CircleUseThreePoints>(prim);
+                auto [center, radius] = circle_center_radius(circle.p1, circle.p2, circle.p3);
+                return circle_bounds(center, radius);
+            } else if constexpr (std::is_same_v<T, Arc>) {
+                if (std::holds_alternative<ArcUseCenterRadiusAngle>(prim)) {
+                    const auto &arc = std::get<ArcUseCenterRadiusAngle>(prim);
+                    return circle_bounds(arc.center, arc.radius);
+                }
+                const auto &arc = std::get<ArcUseThreePoints>(prim);
+                auto [center, radius] = circle_center_radius(arc.p1, arc.p2, arc.p3);
+                return circle_bounds(center, radius);
+            } else if constexpr (std::is_same_v<T, Ellipse>) {
+                constexpr int limit = 1 << 28;
+                const int x = clamp(prim.center.x, -limit, limit);
+                const int y = clamp(prim.center.y, -limit, limit);
+                const int radius_x = ellipse_radius(prim.radius_x);
+                const int radius_y = ellipse_radius(prim.radius_y);
+                return make_bounds(x - radius_x, y - radius_y, x + radius_x + 1, y + radius_y + 1);
+            } else if constexpr (std::is_same_v<T, Rectangle>) {
+                return points_bounds({prim.top_left, prim.bottom_right});
+            } else if constexpr (std::is_same_v<T, Polygon>) {
+                return vector_bounds(prim);
+            } else if constexpr (std::is_same_v<T, BezierCurve> ||
+                                 std::is_same_v<T, BsplineCurve>) {
+                return item.geometry ? vector_bounds(item.geometry->samples) : Bounds{};
+            } else if constexpr (std::is_same_v<T, Fill>) {
+                // 种子填充可能填满整个画布
+                return frame;
+            } else {
+                // 画笔选项、变换和空图元不绘制任何像素
+                return Bounds{};
+            }
+        },
+        primitive);
+    if (bounds.empty()) {
+        return bounds;
+    }
+
+    // 线宽：线宽大于 1 时描边最多超出顶点 Stroker::extent；另留 1 像素余量吸收浮点截断
+    const int pad = item.pen_options.width > 1
+                        ? static_cast<int>(std::ceil(Stroker::extent(item.pen_options)))
+                        : 0;
+    const auto result = bounds_expand(bounds, pad + 1);
+    return bounds_intersect(result, frame);
+}
+
+void RenderEngine::rasterize_items(size_t begin, size_t end, const Bounds &region) {
+    if (tile_engines_.empty()) {
+        scissor_ = region;
+        for (size_t i = begin; i < end; i++) {
+            if (bounds_overlap(render_items_[i].bounds, region)) {
+                rasterize_item(render_items_[i], render_item_primitive(i));
+            }
+        }
+        scissor_ = frame_bounds();
+        return;
+    }
+    // 以 barrier 为界分段，段内分块并行，barrier 在全帧上串行绘制
+    size_t segment_begin = begin;
+    for (size_t i = begin; i < end; i++) {
+        if (!render_items_[i].barrier) {
+            continue;
+        }
+        rasterize_items_tiled(segment_begin, i, region);
+        scissor_ = region;
+        rasterize_item(render_items_[i], render_item_primitive(i));
+        scissor_ = frame_bounds();
+        segment_begin = i + 1;
+    }
+    rasterize_items_tiled(segment_begin, end, region);
+}
+
+void RenderEngine::bin_render_item(size_t index, const Bounds &region, int tiles_x) {
+    const auto &item = render_items_[index];
+    // 把 bounds 内满足 touches 的分块加入，同一渲染项在一个分块中只出现一次
+    const auto add = [&](const Bounds &bounds, auto &&touches) {
+        const auto area = bounds_intersect(bounds_intersect(bounds, item.bounds), region);
+        if (area.empty()) {
+            return;
+        }
+        const int tx0 = (area.min_x - region.min_x) / tile_size;
+        const int ty0 = (area.min_y - region.min_y) / tile_size;
+        const int tx1 = (area.max_x - 1 - region.min_x) / tile_size;
+        const int ty1 = (area.max_y - 1 - region.min_y) / tile_size;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                const int x0 = region.min_x + tx * tile_size;
+                const int y0 = region.min_y + ty * tile_size;
+                if (!touches(make_bounds(x0, y0, x0 + tile_size, y0 + tile_size))) {
+                    continue;
+                }
+                auto &bin = tile_bins_[ty * tiles_x + tx];
+                if (bin.empty() || bin.back() != index) {
+                    bin.push_back(static_cast<uint32_t>(index));
+                }
+            }
+        }
+    };
+    const auto all = [](const Bounds &) { return true; };
+
+    // 细线段、圆、圆弧和曲线只经过包围盒内的一部分分块，其余图元按包围盒放入
+    const auto &primitive = render_item_primitive(index);
+    if (item.pen_options.width > 1) {
+        add(item.bounds, all);
+    } else if (const auto *line = std::get_if<Line>(&primitive);
+               line && line->algorithm != Line::LineAlgorithm::DDA) {
+        // Bresenham 算法和中点算法的第 k 步像素由 LineStepper 直接求出，
+        // 按主方向每 tile_size 步分段，每段的像素都在两端像素的包围盒内
+        const int64_t dx = abs(int64_t{line->p2.x} - line->p1.x);
+        const int64_t dy = abs(int64_t{line->p2.y} - line->p1.y);
+        const bool x_major = dx >= dy;
+        const int64_t major = x_major ? dx : dy;
+        const LineStepper stepper{line->p1, line->p1.x < line->p2.x ? 1 : -1,
+            line->p1.y < line->p2.y ? 1 : -1, x_major, major, x_major ? dy : dx, major - 1};
+        const auto [first, last] = stepper.clip(region, 0, major);
+        for (int64_t k = first; k <= last; k += tile_size) {
+            const auto a = stepper.at(k);
+            const auto b = stepper.at(min(k + tile_size, last));
+            add(make_bounds(min(a.x, b.x), min(a.y, b.y), max(a.x, b.x) + 1, max(a.y, b.y) + 1),
+                all);
+        }
+        // 中点算法最后会重绘起点
+        add(make_bounds(line->p1.x, line->p1.y, line->p1.x + 1, line->p1.y + 1), all);
+    } else if (std::holds_alternative<Circle>(primitive) ||
+               std::holds_alternative<Arc>(primitive)) {
+        // 中点画圆算法的像素到圆心的距离与半径相差不超过 1，只放入与圆环相交的分块
+        Point center{};
+        int radius = 0;
+        if (const auto *circle = std::get_if<Circle>(&primitive)) {
+            if (const auto *c = std::get_if<CircleUseCenterRadius>(circle)) {
+                center = c->center;
+                radius = c->radius;
+            } else {
+                const auto &points = std::get<CircleUseThreePoints>(*circle);
+                std::tie(center, radius) = circle_center_radius(points.p1, points.p2, points.p3);
+            }
+        } else {
+            const auto &arc = std::get<Arc>(primitive);
+            if (const auto *a = std::get_if<ArcUseCenterRadiusAngle>(&arc)) {
+                center = a->center;
+                radius = a->radius;
+            } else {
+                const auto &points = std::get<ArcUseThreePoints>(arc);
+                std::tie(center, radius) = circle_center_radius(points.p1, points.p2, points.p3);
+            }
+        }
+        const double inner = max(std::abs(static_cast<double>(radius)) - 1, 0.0);
+        const double outer = std::abs(static_cast<double>(radius)) + 1;
+        add(item.bounds, [&](const Bounds &tile) {
+            // 分块内的像素到圆心的最近和最远距离
+            const double x0 = static_cast<double>(tile.min_x) - center.x;
+            const double x1 = static_cast<double>(tile.max_x) - 1 - center.x;
+            const double y0 = static_cast<double>(tile.min_y) - center.y;
+            const double y1 = static_cast<double>(tile.max_y) - 1 - center.y;
+            const double near_x = x0 > 0 ? x0 : (x1 < 0 ? -x1 : 0);
+            const double near_y = y0 > 0 ? y0 : (y1 < 0 ? -y1 : 0);
+            const double far_x = max(std::abs(x0), std::abs(x1));
+            const double far_y = max(std::abs(y0), std::abs(y1));
+            return near_x * near_x + near_y * near_y <= outer * outer &&
+                   far_x * far_x + far_y * far_y >= inner * inner;
+        });
+    } else if (item.geometry && !item.geometry->chunks.empty() &&
+               (std::holds_alternative<BezierCurve>(primitive) ||
+                   std::holds_alternative<BsplineCurve>(primitive))) {
+        // 曲线按采样点的分组放入
+        for (const auto &chunk : item.geometry->chunks) {
+            add(chunk.bounds, all);
+        }
+    } else {
+        add(item.bounds, all);
+    }
+}
+
+void RenderEngine::rasterize_items_tiled(size_t begin, size_t end, const Bounds &region) {
+    if (begin >= end || region.empty()) {
+        return;
+    }
+    // 1. 分块
+    const int tiles_x = (region.width() + tile_size - 1) / tile_size;
+    const int tiles_y = (region.height() + tile_size - 1) / tile_size;
+    const auto tile_count = static_cast<size_t>(tiles_x * tiles_y);
+    if (tile_bins_.size() < tile_count) {
+        tile_bins_.resize(tile_count);
+    }
+    for (size_t i = 0; i < tile_count; i++) {
+        tile_bins_[i].clear();
+    }
+    // 2. 把渲染项放入经过的分块，保持图元顺序
+    for (size_t i = begin; i < end; i++) {
+        bin_render_item(i, region, tiles_x);
+    }
+    // 3. 同步各线程的帧缓冲区，画布大小和全局选项在渲染开始时已同步
+    for (auto &tile_engine : tile_engines_) {
+        tile_engine->frame_buffer_ = frame_buffer_;
+    }
+    // 4. 并行绘制各分块，每个像素只属于一个分块，分块内按图元顺序绘制，结果与串行一致
+    thread_pool_->parallel_for(tile_count, [&](size_t tile, size_t thread_index) {
+        const auto &bin = tile_bins_[tile];
+        if (bin.empty()) {
+            return;
+        }
+        auto &tile_engine = *tile_engines_[thread_index];
+        const int tx = static_cast<int>(tile) % tiles_x;
+        const int ty = static_cast<int>(tile) / tiles_x;
+        const int x0 = region.min_x + tx * tile_size;
+        const int y0 = region.min_y + ty * tile_size;
+        tile_engine.scissor_ =
+            bounds_intersect(make_bounds(x0, y0, x0 + tile_size, y0 + tile_size), region);
+        for (const auto index : bin) {
+            tile_engine.rasterize_item(render_items_[index], render_item_primitive(index));
+        }
+    });
+    // 释放对帧缓冲区的引用，否则 acquire_frame_buffer 会认为它被快照引用
+    for (auto &tile_engine : tile_engines_) {
+        tile_engine->frame_buffer_.reset();
+    }
+}
+
+void RenderEngine::rasterize_item(const RenderItem &item, const Primitive &primitive) {
+    pen_options_ = item.pen_options;
+    // 开始进行栅格化
+    // 对于不同的图元，使用不同的栅格化算法
+    // 栅格化后的图元会根据画笔选项进行绘制
+    std::visit(
+        [&](const auto &prim) {
+            using T = std::decay_t<decltype(prim)>;
+            if constexpr (std::is_same_v<T, Line>) {
+                draw_line(prim);
+            } else if constexpr (std::is_same_v<T, Circle>) {
+                draw_circle(prim);
+            } else if constexpr (std::is_same_v<T, Arc>) {
+                draw_arc(prim);
+            } else if constexpr (std::is_same_v<T, Ellipse>) {
+                draw_ellipse(prim);
+            } else if constexpr (std::is_same_v<T, Rectangle>) {
+                draw_rectangle(prim);
+            } else if constexpr (std::is_same_v<T, Polygon>) {
+                draw_polygon(prim, item.geometry && item.geometry->convex);
+            } else if constexpr (std::is_same_v<T, Fill>) {
+                draw_fill(prim);
+            } else if constexpr (std::is_same_v<T, BezierCurve> ||
+                                 std::is_same_v<T, BsplineCurve>) {
+                if (item.geometry) {
+                    draw_curve_samples(item.geometry->samples, item.geometry->chunks);
+                }
+            }
+        },
+        primitive);
+}
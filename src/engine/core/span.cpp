@@ -0,0 +1,44 @@
+#include "engine.hpp"
+
+using namespace RenderCore;
+
+void RenderEngine::draw_span(int y, int x0, int x1, const Color &color) {
+    if (!frame_buffer_ || x0 >= x1) {
+        return;
+    }
+    // 裁剪到绘制区域
+    if (y < scissor_.min_y || y >= scissor_.max_y) {
+        return;
+    }
+    x0 = max(x0, scissor_.min_x);
+    x1 = min(x1, scissor_.max_x);
+    if (x0 >= x1) {
+        return;
+    }
+    // 不透明：混合结果就是颜色本身，直接写入
+    if (color.a == 1.0f) {
+        frame_buffer_->fill_span(y, x0, x1, vector_to_color(color));
+        return;
+    }
+    // 半透明：整段使用相同的混合参数
+    frame_buffer_->blend_span(y, x0, x1, make_blend_source(color, global_options_.blend_mode));
+}
+
+void RenderEngine::draw_rect(const Bounds &bounds, const Color &color) {
+    if (!frame_buffer_) {
+        return;
+    }
+    // 裁剪到绘制区域，颜色只转换一次
+    const auto area = bounds_intersect(bounds, scissor_);
+    if (area.empty()) {
+        return;
+    }
+    if (color.a == 1.0f) {
+        frame_buffer_->fill(vector_to_color(color), area.min_x, area.min_y, area.max_x, area.max_y);
+        return;
+    }
+    const auto source = make_blend_source(color, global_options_.blend_mode);
+    for (int y = area.min_y; y < area.max_y; y++) {
+        frame_buffer_->blend_span(y, area.min_x, area.max_x, source);
+    }
+}
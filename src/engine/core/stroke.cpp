@@ -0,0 +1,26 @@
+#include "stroke.hpp"
+
+#include "engine.hpp"
+
+using namespace RenderCore;
+
+void RenderEngine::draw_stroke(std::span<const Point> points, bool closed) {
+    RenderArena::Scope scope(render_arena_);
+    ScanlineRasterizer rasterizer(&render_arena_);
+    Stroker(pen_options_, rasterizer, &render_arena_).stroke(points, closed);
+    fill_stroke(rasterizer);
+}
+
+void RenderEngine::draw_stroke(std::span<const Vector2d> points, bool closed) {
+    RenderArena::Scope scope(render_arena_);
+    ScanlineRasterizer rasterizer(&render_arena_);
+    Stroker(pen_options_, rasterizer, &render_arena_).stroke(points, closed);
+    fill_stroke(rasterizer);
+}
+
+void RenderEngine::fill_stroke(ScanlineRasterizer &rasterizer) {
+    // 轮廓的右边界不包含在内，线宽为 w 的线段正好覆盖 w 个像素
+    const auto &color = pen_options_.color;
+    rasterizer.rasterize(scissor_, ScanlineRasterizer::FillRule::NON_ZERO,
+        [this, &color](int y, int x0, int x1) { draw_span(y, x0, x1, color); });
+}
@@ -3,14 +3,21 @@
 //
 #include "transform.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <numbers>
+#include <utility>
 #include <variant>
 
 #include "engine.hpp"
 #include "matrix.hpp"
+#include "stroke.hpp"
 
 using namespace RenderCore;
 
+extern std::pair<Point, int> circle_center_radius(
+    const Point &p1, const Point &p2, const Point &p3);
+
 Matrix3f make_translate_matrix(float x, float y) {
     // 1  0  x
     // 0  1  y
@@ -55,3 +62,224 @@ Matrix3f make_transform_matrix(const Transform &transform) {
 void RenderEngine::make_transform(const Transform &transform) {
     transform_matrix_ = make_transform_matrix(transform) * transform_matrix_;
 }
+
+namespace {
+
+// 用三次贝塞尔曲线近似圆弧时允许的最大偏差（像素）
+constexpr double arc_tolerance = 0.1;
+// 近似一段圆弧的贝塞尔曲线段数上限
+constexpr int max_arc_segments = 1024;
+
+// 相似变换（旋转、均匀缩放、平移及镜像）把圆映射为圆，返回缩放比例，不是相似变换时返回 0
+double similarity_scale(const Matrix3f &m) {
+    const double a = m[0][0], b = m[0][1], c = m[1][0], d = m[1][1];
+    const double scale = std::hypot(a, c);
+    const double epsilon = 1e-5 * scale;
+    const bool rotation = std::abs(a - d) <= epsilon && std::abs(b + c) <= epsilon;
+    const bool reflection = std::abs(a + d) <= epsilon && std::abs(b - c) <= epsilon;
+    return rotation || reflection ? scale : 0;
+}
+
+// 变换对长度的最大放大倍数的上界
+double max_stretch(const Matrix3f &m) {
+    return std::hypot(std::hypot(m[0][0], m[0][1]), std::hypot(m[1][0], m[1][1]));
+}
+
+bool axis_aligned(const Matrix3f &m) {
+    return m[0][1] == 0 && m[1][0] == 0;
+}
+
+// 变换后取整，与 TransformMatrixApply<Point> 相同
+Point transform_point(const Matrix3f &m, double x, double y) {
+    const auto p = m * Vector2f(static_cast<float>(x), static_cast<float>(y)).xy1();
+    return {static_cast<int>(p.x), static_cast<int>(p.y)};
+}
+
+// 把椭圆弧 [start, end] 分成圆心角不超过 π/2 的几段，每段用三次贝塞尔曲线近似后变换控制点，
+// 拼接成节点重复 3 次的三次 B 样条曲线。仿射变换下近似曲线的变换就是控制点的变换
+BsplineCurve transform_elliptic_arc(const Point &center, double radius_x, double radius_y,
+    double start, double end, const Matrix3f &m) {
+    // 圆心角为 θ 的近似的半径误差约为 1.8e-5 · r · θ⁶
+    const double radius = std::max(radius_x, radius_y) * max_stretch(m);
+    const double max_angle = std::min(std::numbers::pi / 2,
+        std::pow(arc_tolerance / (1.8e-5 * std::max(radius, 1.0)), 1.0 / 6));
+    const auto segments = static_cast<int>(
+        std::clamp(std::ceil((end - start) / max_angle), 1.0, double{max_arc_segments}));
+    BsplineCurve curve;
+    const auto point = [&](double angle, double scale) {
+        const double c = std::cos(angle), s = std::sin(angle);
+        return Vector2d(radius_x * c, radius_y * s) + Vector2d(-radius_x * s, radius_y * c) * scale;
+    };
+    const double step = (end - start) / segments;
+    // 控制柄长度为 4/3 · tan(θ / 4)
+    const double handle = 4.0 / 3 * std::tan(step / 4);
+    const auto add = [&](const Vector2d &offset) {
+        curve.control_points.push_back(
+            transform_point(m, center.x + offset.x, center.y + offset.y));
+    };
+    for (int i = 0; i < segments; i++) {
+        const double a0 = start + step * i;
+        const double a1 = i + 1 == segments ? end : a0 + step;
+        if (i == 0) {
+            add(point(a0, 0));
+        }
+        add(point(a0, handle));
+        add(point(a1, -handle));
+        add(point(a1, 0));
+    }
+    curve.knots.assign(4, 0.0f);
+    for (int i = 1; i < segments; i++) {
+        curve.knots.insert(curve.knots.end(), 3, static_cast<float>(i));
+    }
+    curve.knots.insert(curve.knots.end(), 4, static_cast<float>(segments));
+    return curve;
+}
+
+Primitive transform_rectangle(const Rectangle &rectangle, const Matrix3f &m) {
+    if (axis_aligned(m)) {
+        // 平移和缩放后仍是矩形
+        const auto p1 = transform_point(m, rectangle.min_x(), rectangle.min_y());
+        const auto p2 = transform_point(m, rectangle.max_x(), rectangle.max_y());
+        return make_rectangle({std::min(p1.x, p2.x), std::min(p1.y, p2.y)},
+            {std::max(p1.x, p2.x), std::max(p1.y, p2.y)});
+    }
+    auto polygon = cast_rectangle_to_polygon(rectangle);
+    apply_transform_matrix(polygon, m);
+    return polygon;
+}
+
+Primitive transform_ellipse(const Ellipse &ellipse, const Matrix3f &m) {
+    const int radius_x = ellipse_radius(ellipse.radius_x);
+    const int radius_y = ellipse_radius(ellipse.radius_y);
+    if (axis_aligned(m)) {
+        // 平移和缩放后仍是坐标轴方向的椭圆
+        return make_ellipse(transform_point(m, ellipse.center.x, ellipse.center.y),
+            static_cast<int>(std::lround(std::abs(m[0][0]) * radius_x)),
+            static_cast<int>(std::lround(std::abs(m[1][1]) * radius_y)));
+    }
+    // 旋转后的椭圆折线化为多边形，内部填充和边线与椭圆相同
+    const double radius = std::max(radius_x, radius_y) * max_stretch(m);
+    const auto segments = std::max(Stroker::arc_segment_count(radius, 2 * std::numbers::pi), 8);
+    Polygon polygon;
+    for (int i = 0; i < segments; i++) {
+        const double angle = 2 * std::numbers::pi * i / segments;
+        polygon.push_back(transform_point(m, ellipse.center.x + radius_x * std::cos(angle),
+            ellipse.center.y + radius_y * std::sin(angle)));
+    }
+    return polygon;
+}
+
+Primitive transform_circle(const Circle &circle, const Matrix3f &m) {
+    const double scale = similarity_scale(m);
+    if (const auto *three_points = std::get_if<CircleUseThreePoints>(&circle)) {
+        if (scale > 0) {
+            // 相似变换后仍是过三个变换后的点的圆
+            auto result = *three_points;
+            apply_transform_matrix(result.p1, m);
+            apply_transform_matrix(result.p2, m);
+            apply_transform_matrix(result.p3, m);
+            return Circle{result};
+        }
+        const auto [center, radius] =
+            circle_center_radius(three_points->p1, three_points->p2, three_points->p3);
+        return transform_elliptic_arc(
+            center, radius, radius, -std::numbers::pi, std::numbers::pi, m);
+    }
+    const auto &center_radius = std::get<CircleUseCenterRadius>(circle);
+    if (scale > 0) {
+        return make_circle_center_radius(
+            transform_point(m, center_radius.center.x, center_radius.center.y),
+            static_cast<int>(std::lround(center_radius.radius * scale)));
+    }
+    const double radius = center_radius.radius;
+    return transform_elliptic_arc(
+        center_radius.center, radius, radius, -std::numbers::pi, std::numbers::pi, m);
+}
+
+Primitive transform_arc(const Arc &arc, const Matrix3f &m) {
+    const double scale = similarity_scale(m);
+    if (const auto *three_points = std::get_if<ArcUseThreePoints>(&arc)) {
+        if (scale > 0) {
+            auto result = *three_points;
+            apply_transform_matrix(result.p1, m);
+            apply_transform_matrix(result.p2, m);
+            apply_transform_matrix(result.p3, m);
+            return Arc{result};
+        }
+        // 与 draw_arc 相同：从 p1 到 p3 经过 p2 的一侧
+        const auto &[p1, p2, p3] = *three_points;
+        const auto [center, radius] = circle_center_radius(p1, p2, p3);
+        double start = std::atan2(p1.y - center.y, p1.x - center.x);
+        double end = std::atan2(p3.y - center.y, p3.x - center.x);
+        if (start > end) {
+            std::swap(start, end);
+        }
+        const double middle = std::atan2(p2.y - center.y, p2.x - center.x);
+        if (middle < start || middle > end) {
+            std::swap(start, end);
+            end += 2 * std::numbers::pi;
+        }
+        return transform_elliptic_arc(center, radius, radius, start, end, m);
+    }
+    const auto &angles = std::get<ArcUseCenterRadiusAngle>(arc);
+    if (std::isnan(angles.start_angle) || std::isnan(angles.end_angle)) {
+        return std::monostate{};
+    }
+    // 与 draw_arc_midpoint 相同：极角在 [-π, π] 内且在两个角度之间的点
+    const double start = std::max<double>(
+        std::min(angles.start_angle, angles.end_angle), -std::numbers::pi);
+    const double end =
+        std::min<double>(std::max(angles.start_angle, angles.end_angle), std::numbers::pi);
+    if (start > end) {
+        return std::monostate{};
+    }
+    const double determinant = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    if (scale > 0 && determinant > 0) {
+        // 旋转后角度范围仍在 [-π, π] 内时仍是圆弧
+        const double rotation = std::atan2(m[1][0], m[0][0]);
+        double new_start = start + rotation;
+        double new_end = end + rotation;
+        if (new_start < -std::numbers::pi) {
+            new_start += 2 * std::numbers::pi;
+            new_end += 2 * std::numbers::pi;
+        } else if (new_start >= std::numbers::pi) {
+            new_start -= 2 * std::numbers::pi;
+            new_end -= 2 * std::numbers::pi;
+        }
+        if (rotation == 0 || new_end <= std::numbers::pi) {
+            return make_arc_center_radius_angle(
+                transform_point(m, angles.center.x, angles.center.y),
+                static_cast<int>(std::lround(angles.radius * scale)),
+                static_cast<float>(rotation == 0 ? start : new_start),
+                static_cast<float>(rotation == 0 ? end : new_end));
+        }
+    }
+    const double radius = angles.radius;
+    return transform_elliptic_arc(angles.center, radius, radius, start, end, m);
+}
+
+}  // namespace
+
+void TransformMatrixApply<Primitive>::operator()(
+    Primitive &primitive, const Matrix3f &transform) const {
+    if (transform == Matrix3f::identity()) {
+        return;
+    }
+    std::visit(
+        [&](auto &prim) {
+            using T = std::decay_t<decltype(prim)>;
+            if constexpr (can_apply_transform_matrix_v<T>) {
+                apply_transform_matrix(prim, transform);
+            } else if constexpr (std::is_same_v<T, Rectangle>) {
+                primitive = transform_rectangle(prim, transform);
+            } else if constexpr (std::is_same_v<T, Ellipse>) {
+                primitive = transform_ellipse(prim, transform);
+            } else if constexpr (std::is_same_v<T, Circle>) {
+                primitive = transform_circle(prim, transform);
+            } else if constexpr (std::is_same_v<T, Arc>) {
+                primitive = transform_arc(prim, transform);
+            }
+            // 画笔选项、变换和空图元不受影响
+        },
+        primitive);
+}
@@ -0,0 +1,125 @@
+#ifndef RENDERENGINE_ARENA_HPP
+#define RENDERENGINE_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+namespace RenderCore {
+class RenderArena;
+}
+
+// 渲染过程使用的临时内存池
+// 从预先分配的缓冲区顺序分配，单次释放不回收内存，Scope 结束时回退到进入时的位置
+// 缓冲区不够时向上游申请，reset() 时释放这些内存，并把缓冲区扩大到本轮的最大用量
+// 不是线程安全的，每个渲染线程使用自己的内存池
+class RenderCore::RenderArena : public std::pmr::memory_resource {
+    // 保留的缓冲区上限，超出部分每轮向上游申请
+    static constexpr size_t max_capacity = 16 * 1024 * 1024;
+
+    struct Block {
+        void *pointer;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t capacity_{0};
+    size_t offset_{0};
+    // 缓冲区不够时向上游申请的内存
+    std::vector<Block> overflow_;
+    size_t overflow_bytes_{0};
+    // 本轮同时使用的最大字节数
+    size_t peak_{0};
+    std::pmr::memory_resource *upstream_;
+
+   public:
+    // 进入时记录分配位置，结束时回退，期间分配的内存在结束后不能再使用
+    class Scope {
+        RenderArena &arena_;
+        size_t offset_;
+
+       public:
+        explicit Scope(RenderArena &arena) : arena_(arena), offset_(arena.offset_) {}
+
+        ~Scope() { arena_.offset_ = offset_; }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    explicit RenderArena(size_t capacity = 64 * 1024,
+        std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : buffer_(std::make_unique<std::byte[]>(capacity)),
+          capacity_(capacity),
+          upstream_(upstream) {}
+
+    ~RenderArena() override { release_overflow(); }
+
+    RenderArena(const RenderArena &) = delete;
+    RenderArena &operator=(const RenderArena &) = delete;
+
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+
+    // 整体释放，之后可以重新使用全部缓冲区
+    void reset() {
+        release_overflow();
+        if (peak_ > capacity_ && capacity_ < max_capacity) {
+            capacity_ = std::min(std::max(peak_, capacity_ * 2), max_capacity);
+            buffer_ = std::make_unique<std::byte[]>(capacity_);
+        }
+        offset_ = 0;
+        peak_ = 0;
+    }
+
+   protected:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        const auto begin = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (begin + bytes <= capacity_) {
+            offset_ = begin + bytes;
+            peak_ = std::max(peak_, offset_ + overflow_bytes_);
+            return buffer_.get() + begin;
+        }
+        auto *pointer = upstream_->allocate(bytes, alignment);
+        overflow_.push_back({pointer, bytes, alignment});
+        overflow_bytes_ += bytes;
+        peak_ = std::max(peak_, begin + overflow_bytes_);
+        return pointer;
+    }
+
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+        // 缓冲区内的内存由 Scope 和 reset() 回收
+        const auto *address = static_cast<std::byte *>(pointer);
+        if (address >= buffer_.get() && address < buffer_.get() + capacity_) {
+            return;
+        }
+        // 上游的内存立即归还，一般是最近申请的，从后往前查找
+        for (auto it = overflow_.rbegin(); it != overflow_.rend(); ++it) {
+            if (it->pointer == pointer) {
+                upstream_->deallocate(pointer, bytes, alignment);
+                overflow_bytes_ -= it->bytes;
+                overflow_.erase(std::next(it).base());
+                return;
+            }
+        }
+    }
+
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+   private:
+    void release_overflow() {
+        for (const auto &block : overflow_) {
+            upstream_->deallocate(block.pointer, block.bytes, block.alignment);
+        }
+        overflow_.clear();
+        overflow_bytes_ = 0;
+    }
+};
+
+#endif  //RENDERENGINE_ARENA_HPP
@@ -11,6 +11,7 @@
 #ifndef RENDERENGINE_BITMAP_HPP
 #define RENDERENGINE_BITMAP_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -18,6 +19,8 @@
 #include <memory>
 #include <vector>
 
+#include "blend.hpp"
+
 namespace RenderCore {
 class Bitmap;
 }
@@ -61,6 +64,9 @@ class RenderCore::Bitmap {
 
     [[nodiscard]] inline const uint8_t *data() { return data_; }
 
+    // 像素数据的字节数
+    [[nodiscard]] inline size_t size() const { return static_cast<size_t>(pitch_) * height_; }
+
     [[nodiscard]] inline uint8_t *line(int32_t y) { return data_ + y * pitch_; }
 
     [[nodiscard]] inline const uint8_t *line(int32_t y) const { return data_ + y * pitch_; }
@@ -75,6 +81,38 @@ class RenderCore::Bitmap {
         }
     }
 
+    // 复制同样大小的位图的内容
+    inline void copy_from(const Bitmap &bitmap) {
+        assert(width_ == bitmap.width_ && height_ == bitmap.height_);
+        std::memcpy(data_, bitmap.data_, size());
+    }
+
+    // 填充矩形区域 [x0, x1) x [y0, y1)，区域需在位图范围内
+    inline void fill(uint32_t color, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+        for (int i = y0; i < y1; i++) {
+            fill_span(i, x0, x1, color);
+        }
+    }
+
+    // 填充第 y 行的 [x0, x1)，区间需在位图范围内
+    inline void fill_span(int32_t y, int32_t x0, int32_t x1, uint32_t color) {
+        assert(y >= 0 && y < height_ && x0 >= 0 && x0 <= x1 && x1 <= width_);
+        auto *row = reinterpret_cast<uint32_t *>(data_ + y * pitch_);
+        std::fill(row + x0, row + x1, color);
+    }
+
+    // 将第 y 行的 [x0, x1) 与 source 混合，区间需在位图范围内
+    inline void blend_span(int32_t y, int32_t x0, int32_t x1, const BlendSource &source) {
+        assert(y >= 0 && y < height_ && x0 >= 0 && x0 <= x1 && x1 <= width_);
+        auto *row = reinterpret_cast<uint32_t *>(data_ + y * pitch_);
+        blend_row(row + x0, x1 - x0, source);
+    }
+
+    // 第 y 行的像素
+    [[nodiscard]] inline uint32_t *pixels(int32_t y) {
+        return reinterpret_cast<uint32_t *>(data_ + y * pitch_);
+    }
+
     inline void set_pixel(int32_t x, int32_t y, uint32_t color) {
         assert(x >= 0 && x < width_ && y >= 0 && y < height_);
         auto *pixel = reinterpret_cast<uint32_t *>(data_ + y * pitch_ + x * 4);
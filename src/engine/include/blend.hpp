@@ -0,0 +1,78 @@
+#ifndef RENDERENGINE_BLEND_HPP
+#define RENDERENGINE_BLEND_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "color.hpp"
+#include "utils.hpp"
+
+namespace RenderCore {
+
+// 颜色混合模式
+enum class BlendMode {
+    FLOAT,  // 浮点混合，与 blend_color 的结果逐位一致
+    FIXED,  // 8 位定点混合，颜色分量在 [0, 1] 内时与浮点混合相差不超过 1
+};
+
+// 混合内核
+enum class BlendKernel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+// 预先计算的混合参数
+// 混合一段像素时只需计算一次
+struct BlendSource {
+    BlendMode mode{BlendMode::FLOAT};
+    // 浮点：src * alpha 和 1 - alpha
+    Vector4f src_term;
+    float inv_alpha{0};
+    // 定点：round(src * alpha * 255 * 256) 和 round((1 - alpha) * 256)
+    uint16_t src_fixed[4]{};
+    uint16_t inv_alpha_fixed{0};
+};
+
+inline BlendSource make_blend_source(const Color &color, BlendMode mode) {
+    BlendSource source;
+    source.mode = mode;
+    if (mode == BlendMode::FLOAT) {
+        source.src_term = color * color.a;
+        source.inv_alpha = 1 - color.a;
+    } else {
+        const auto alpha = saturate(color.a);
+        for (size_t i = 0; i < 4; i++) {
+            source.src_fixed[i] =
+                static_cast<uint16_t>(std::lround(saturate(color[i]) * alpha * 255.0f * 256.0f));
+        }
+        source.inv_alpha_fixed = static_cast<uint16_t>(std::lround((1 - alpha) * 256.0f));
+    }
+    return source;
+}
+
+// 混合单个像素
+inline uint32_t blend_pixel(uint32_t dst, const BlendSource &source) {
+    if (source.mode == BlendMode::FLOAT) {
+        return blend_color(dst, source.src_term, source.inv_alpha);
+    }
+    // src_fixed + dst * inv_alpha_fixed 不超过 65408，右移 8 位后不超过 255
+    uint32_t result = 0;
+    for (size_t i = 0; i < 4; i++) {
+        const uint32_t channel = (dst >> (i * 8)) & 0xFF;
+        result |= ((source.src_fixed[i] + channel * source.inv_alpha_fixed) >> 8) << (i * 8);
+    }
+    return result;
+}
+
+// 混合一行中连续的 count 个像素，结果与逐个调用 blend_pixel 一致
+// 首次调用时根据 CPU 支持选择 AVX2、SSE2 或标量实现
+void blend_row(uint32_t *row, size_t count, const BlendSource &source);
+
+// 当前使用的混合内核
+BlendKernel blend_kernel();
+
+}  // namespace RenderCore
+
+#endif  //RENDERENGINE_BLEND_HPP
@@ -0,0 +1,65 @@
+#ifndef RENDERENGINE_BOUNDS_HPP
+#define RENDERENGINE_BOUNDS_HPP
+
+#include "utils.hpp"
+
+namespace RenderCore {
+
+// 屏幕空间包围盒
+// 左闭右开：[min_x, max_x) x [min_y, max_y)
+struct Bounds {
+    int min_x{0};
+    int min_y{0};
+    int max_x{0};
+    int max_y{0};
+
+    [[nodiscard]] bool empty() const { return min_x >= max_x || min_y >= max_y; }
+
+    [[nodiscard]] bool contains(int x, int y) const {
+        return x >= min_x && x < max_x && y >= min_y && y < max_y;
+    }
+
+    [[nodiscard]] int width() const { return max_x - min_x; }
+
+    [[nodiscard]] int height() const { return max_y - min_y; }
+};
+
+inline Bounds make_bounds(int min_x, int min_y, int max_x, int max_y) {
+    return Bounds{min_x, min_y, max_x, max_y};
+}
+
+// 两个包围盒的交集
+inline Bounds bounds_intersect(const Bounds &a, const Bounds &b) {
+    return Bounds{max(a.min_x, b.min_x), max(a.min_y, b.min_y), min(a.max_x, b.max_x),
+        min(a.max_y, b.max_y)};
+}
+
+// 两个包围盒是否相交
+inline bool bounds_overlap(const Bounds &a, const Bounds &b) {
+    return !bounds_intersect(a, b).empty();
+}
+
+// 包含两个包围盒的最小包围盒
+inline Bounds bounds_union(const Bounds &a, const Bounds &b) {
+    if (a.empty()) {
+        return b;
+    }
+    if (b.empty()) {
+        return a;
+    }
+    return Bounds{min(a.min_x, b.min_x), min(a.min_y, b.min_y), max(a.max_x, b.max_x),
+        max(a.max_y, b.max_y)};
+}
+
+// 向四周扩展
+inline Bounds bounds_expand(const Bounds &bounds, int margin) {
+    if (bounds.empty()) {
+        return bounds;
+    }
+    return Bounds{bounds.min_x - margin, bounds.min_y - margin, bounds.max_x + margin,
+        bounds.max_y + margin};
+}
+
+}  // namespace RenderCore
+
+#endif  //RENDERENGINE_BOUNDS_HPP
@@ -5,6 +5,9 @@
 #ifndef RENDERENGINE_CIRCLE_HPP
 #define RENDERENGINE_CIRCLE_HPP
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <variant>
 
 #include "point.hpp"
@@ -52,6 +55,26 @@ inline Arc make_arc_three_points(const Point &p1, const Point &p2, const Point &
     return ArcUseThreePoints{p1, p2, p3};
 }
 
+// 椭圆
+// 内部使用画笔的填充色填充，边线使用画笔颜色，两个半径相等时为实心圆
+struct Ellipse {
+    Point center;
+    int radius_x;
+    int radius_y;
+};
+
+inline Ellipse make_ellipse(const Point &center, int radius_x, int radius_y) {
+    return Ellipse{center, radius_x, radius_y};
+}
+
+// 椭圆半径的上限，超过时决策参数会超出 64 位整数的范围
+constexpr int max_ellipse_radius = 1 << 14;
+
+// 绘制时实际使用的半径：取绝对值并限制在上限内
+inline int ellipse_radius(int radius) {
+    return static_cast<int>(std::min<int64_t>(std::abs(int64_t{radius}), max_ellipse_radius));
+}
+
 }  // namespace RenderCore
 
 #endif  //RENDERENGINE_CIRCLE_HPP
@@ -35,6 +35,13 @@ constexpr inline static Vector4f color_to_vector(uint32_t color) {
     return {r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f};
 }
 
+// 颜色混合：src * alpha + dst * (1 - alpha)
+// src_term 为 src * alpha，inv_alpha 为 1 - alpha，混合一段像素时只需计算一次
+constexpr inline static uint32_t blend_color(
+    uint32_t dst, const Vector4f &src_term, float inv_alpha) {
+    return vector_to_color(src_term + color_to_vector(dst) * inv_alpha);
+}
+
 namespace Colors {
 const Color Black{0, 0, 0, 1};
 const Color White{1, 1, 1, 1};
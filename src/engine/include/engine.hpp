@@ -6,20 +6,28 @@
 #define RENDERENGINE_ENGINE_HPP
 
 #include <functional>
-#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <type_traits>
 #include <variant>
 #include <vector>
 
+#include "arena.hpp"
 #include "bitmap.hpp"
+#include "bounds.hpp"
+#include "geometry_cache.hpp"
+#include "image_encoder.hpp"
 #include "line.hpp"
 #include "matrix.hpp"
 #include "options.hpp"
 #include "point.hpp"
 #include "polygon.hpp"
 #include "primitive.hpp"
+#include "primitive_list.hpp"
+#include "scanline.hpp"
+#include "thread_pool.hpp"
 #include "transform.hpp"
 #include "vector.hpp"
 
@@ -30,21 +38,101 @@ class RenderEngine;
 class RenderCore::RenderEngine {
     // 帧缓冲区
     // 调用 render() 时，将绘制到此缓冲区
-    std::unique_ptr<Bitmap> frame_buffer_;
-
-    // 存储所有图元
-    // Primitive 是一个变体类型，可以存储多种图元
-    // PenOptions 类型的图元会使接下来的图元使用指定的画笔选项，直到下一个 PenOptions 类型的图元
-    // Transform 类型的图元会使接下来的可绘制图元使用指定的变换矩阵，仅对接下来的一个图元有效
-    // 多个 Transform 类型的图元会叠加变换矩阵
-    // 如：[..., T1, T2, L1, ...] 代表先对 L1 进行 T1 变换，再对结果进行 T2 变换
-    std::vector<Primitive> primitives_;
-
-    // 存储需要渲染的图元
-    // 渲染时，会先将 primitives_ 中的图元复制到 render_primitives_ 中
-    // 然后遍历 render_primitives_ 进行渲染
-    // 因为可能对图元进行裁剪等操作，所以需要复制一份
-    std::list<Primitive> render_primitives_;
+    // 分块并行渲染时与各线程的 tile_engines_ 共享
+    // 通过 get_frame() 交出的快照不可变，帧缓冲区被快照引用时，渲染前会换到空闲的缓冲区
+    std::shared_ptr<Bitmap> frame_buffer_;
+
+    // 之前的帧缓冲区，可能仍被快照引用，不再被引用时可以重新使用
+    std::vector<std::shared_ptr<Bitmap>> frame_pool_;
+    // 帧缓冲区总数（包含 frame_buffer_），即三重缓冲
+    static constexpr size_t frame_buffer_count = 3;
+
+    // 对已有图元的插入、删除、修改，渲染开始时按顺序应用到 render_items_
+    struct PrimitiveEdit {
+        enum class Type { INSERT, REMOVE, MODIFY } type;
+        size_t index;
+        // 涉及画笔选项、变换等状态图元（插入的图元，删除、修改前后的图元）
+        bool state;
+    };
+
+    // 编辑状态
+    // 编辑图元和全局选项的接口只修改这里的状态，由 edit_mutex_ 保护，可以与渲染并发调用
+    // 渲染开始时在锁内取得图元快照和编辑记录，之后的绘制不再访问编辑状态
+    struct EditState {
+        // 存储所有图元
+        // Primitive 是一个变体类型，可以存储多种图元
+        // PenOptions 类型的图元会使接下来的图元使用指定的画笔选项，直到下一个 PenOptions 类型的图元
+        // Transform 类型的图元会使接下来的可绘制图元使用指定的变换矩阵，仅对接下来的一个图元有效
+        // 多个 Transform 类型的图元会叠加变换矩阵
+        // 如：[..., T1, T2, L1, ...] 代表先对 L1 进行 T1 变换，再对结果进行 T2 变换
+        PrimitiveList primitives;
+        // 最近一次发布的快照，编辑后失效，需要时再重新发布
+        std::shared_ptr<const PrimitiveList> snapshot;
+        // 上次渲染之后对已有图元的编辑
+        std::vector<PrimitiveEdit> edits;
+        GlobalOptions global_options;
+        // 调用过 init()，可以添加图元
+        bool initialized{false};
+        bool full_redraw{true};
+        bool need_render{true};
+    };
+
+    // 编辑记录数量上限，超过时改为重绘整帧
+    static constexpr size_t max_pending_edits = 1024;
+
+    // 持有锁的线程可以继续调用编辑接口，见 lock_edits()
+    mutable std::recursive_mutex edit_mutex_;
+    // 读者取得快照时可能需要发布新的快照
+    mutable EditState edit_;
+
+    // 本次渲染使用的图元快照
+    // 渲染开始时取得，渲染结束后释放，之后的编辑不必再复制被快照共享的分块
+    std::shared_ptr<const PrimitiveList> primitives_;
+    // 本次渲染需要应用的编辑记录，与 edit_.edits 交换，复用容量
+    std::vector<PrimitiveEdit> pending_edits_;
+
+    // 渲染项
+    // 图元经过变换、裁剪后的结果，以及绘制它时生效的画笔选项、变换矩阵和屏幕空间包围盒
+    // 记录了绘制时的状态，每个渲染项都可以独立绘制，不依赖前面的图元
+    struct RenderItem {
+        // 变换、裁剪后的图元和曲线的采样点，与派生几何缓存共享
+        // 只有需要变换、裁剪或采样的图元才有派生几何，其余图元绘制时直接引用快照中的原始图元
+        std::shared_ptr<const DerivedGeometry> geometry;
+        // 绘制时生效的画笔选项
+        PenOptions pen_options;
+        // 绘制前生效的变换矩阵（由前面的 Transform 图元叠加而成），在栅格化前应用到派生几何
+        Matrix3f transform_matrix = Matrix3f::identity();
+        Bounds bounds;
+        // 需要读取帧缓冲区的图元（如种子填充），结果依赖之前所有图元，只能在全帧上串行绘制
+        bool barrier{false};
+        // 图元被修改或新插入，需要重新变换、裁剪并计算包围盒
+        bool dirty{false};
+    };
+
+    // 存储已经绘制到帧缓冲区的图元对应的渲染项
+    // 渲染时，会先将 primitives_ 中的图元变换、裁剪后存入 render_items_
+    // 需要变换、裁剪的图元复制一份，其余图元在绘制时从 primitives_ 中按下标取得
+    // render_items_ 与 primitives_ 的前 render_items_.size() 个图元一一对应，在多次渲染之间保留
+    // 之后的图元是尚未绘制的追加图元，下次渲染时直接绘制在已有画面上
+    std::vector<RenderItem> render_items_;
+
+    // 派生几何缓存
+    // 重绘整帧时内容没有改变的图元直接复用之前的变换、裁剪和采样结果
+    GeometryCache geometry_cache_;
+
+    // 脏区域
+    // 被修改、删除的图元覆盖的区域，下次渲染时只清空并重绘这些区域，区域之间互不重叠
+    std::vector<Bounds> dirty_regions_;
+    // 脏区域数量上限，超过时合并为一个区域
+    static constexpr size_t max_dirty_regions = 16;
+
+    // 需要重绘整帧
+    // 修改画笔选项、变换或全局选项等影响后续所有图元的操作时设置为 true
+    bool full_redraw_{true};
+
+    // 绘制完所有渲染项后的画笔选项和变换矩阵，追加图元时从这里继续
+    PenOptions tail_pen_options_;
+    Matrix3f tail_transform_matrix_ = Matrix3f::identity();
 
     // 画布宽高
     int32_t width_;
@@ -57,24 +145,52 @@ class RenderCore::RenderEngine {
 
     // 全局选项
     // 指定背景色、裁剪窗口等
+    // 渲染开始时从编辑状态复制
     GlobalOptions global_options_;
 
     // 变换矩阵
     // 用于对图元进行变换
     Matrix3f transform_matrix_ = Matrix3f::identity();
 
-    // 需要重新渲染
-    // 在添加、修改图元时设置为 true
-    bool need_render_{true};
+    // 帧版本
+    // 帧缓冲区的内容每次改变时递增，用于判断两次取得的帧是否相同
+    uint64_t frame_version_{0};
+
+    // 保存文件时使用的编码器，复用输出缓冲区
+    ImageEncoder image_encoder_;
+
+    // 绘制区域
+    // draw_pixel 只写入此区域内的像素，分块渲染时为当前分块
+    Bounds scissor_;
+
+    // 渲染过程中的临时内存
+    // 裁剪、扫描线、种子填充和曲线求值的临时容器从这里分配，每轮 render() 结束时整体释放
+    // 并行渲染时各线程使用自己的 tile_engines_ 中的内存池
+    mutable RenderArena render_arena_;
+
+    // 分块渲染
+    // 分块的边长（像素）
+    static constexpr int tile_size = 64;
+    // 渲染线程数，小于等于 1 时串行渲染
+    int render_threads_{1};
+    std::unique_ptr<ThreadPool> thread_pool_;
+    // 每个渲染线程私有的绘制上下文，共享 frame_buffer_
+    std::vector<std::unique_ptr<RenderEngine>> tile_engines_;
+    // 每个分块内需要绘制的渲染项下标，按图元顺序排列
+    std::vector<std::vector<uint32_t>> tile_bins_;
 
    public:
     using Buffer = Bitmap::Buffer;
+    // 帧快照
+    using Frame = std::shared_ptr<const Bitmap>;
 
    public:
     RenderEngine() : frame_buffer_(nullptr), width_(0), height_(0) {}
 
-    RenderEngine(int32_t width, int32_t height)
+    // render_threads 为渲染线程数，大于 1 时使用分块并行渲染
+    RenderEngine(int32_t width, int32_t height, int render_threads = 1)
         : frame_buffer_(nullptr), width_(width), height_(height) {
+        set_render_threads(render_threads);
         init(width, height);
     }
 
@@ -85,10 +201,39 @@ class RenderCore::RenderEngine {
     void init(int32_t width, int32_t height) {
         width_ = width;
         height_ = height;
-        frame_buffer_ = std::make_unique<Bitmap>(width, height);
+        frame_buffer_ = std::make_shared<Bitmap>(width, height);
+        frame_pool_.clear();
+        frame_version_++;
+        scissor_ = frame_bounds();
+        full_redraw_ = true;
+        {
+            std::lock_guard lock(edit_mutex_);
+            edit_.initialized = true;
+            edit_.full_redraw = true;
+            edit_.need_render = true;
+        }
         fill_with_background_color();
     }
 
+    // 设置渲染线程数
+    // 输出与串行渲染逐像素一致
+    void set_render_threads(int threads) {
+        render_threads_ = threads > 1 ? threads : 1;
+        tile_engines_.clear();
+        thread_pool_.reset();
+        if (render_threads_ > 1) {
+            thread_pool_ = std::make_unique<ThreadPool>(render_threads_);
+            for (int i = 0; i < render_threads_; i++) {
+                tile_engines_.push_back(std::make_unique<RenderEngine>());
+            }
+        }
+    }
+
+    [[nodiscard]] int get_render_threads() const { return render_threads_; }
+
+    // 整个画布的范围
+    [[nodiscard]] Bounds frame_bounds() const { return make_bounds(0, 0, width_, height_); }
+
     // 清空画布，以背景色填充
     void fill_with_background_color() {
         const auto color = vector_to_color(global_options_.background_color);
@@ -99,60 +244,93 @@ class RenderCore::RenderEngine {
 
     // 初始化画布
     void clear() {
-        primitives_.clear();
+        {
+            std::lock_guard lock(edit_mutex_);
+            edit_.primitives.clear();
+            edit_.snapshot.reset();
+            edit_.edits.clear();
+            edit_.global_options = {};
+            edit_.full_redraw = true;
+        }
+        primitives_.reset();
+        render_items_.clear();
+        geometry_cache_.clear();
+        dirty_regions_.clear();
         global_options_ = {};
+        full_redraw_ = true;
+        acquire_frame_buffer();
         fill_with_background_color();
+        frame_version_++;
     }
 
     void set_global_options(const GlobalOptions &options) {
-        global_options_ = options;
-        need_render_ = true;
+        std::lock_guard lock(edit_mutex_);
+        edit_.global_options = options;
+        // 背景色、裁剪窗口影响所有图元
+        edit_.full_redraw = true;
+        edit_.need_render = true;
+        edit_.edits.clear();
     }
 
-    [[nodiscard]] const GlobalOptions &get_global_options() const { return global_options_; }
+    [[nodiscard]] GlobalOptions get_global_options() const {
+        std::lock_guard lock(edit_mutex_);
+        return edit_.global_options;
+    }
 
     // 绘制像素
     void draw_pixel(int x, int y, const Color &color) {
         if (!frame_buffer_) {
             return;
         }
-        // 忽略超出范围的点
-        if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+
+        // 忽略绘制区域外的点
+        if (!scissor_.contains(x, y)) {
             return;
         }
 
-        // 变换
-        // 变换矩阵不是单位矩阵时，对点进行变换
-        if (transform_matrix_ != Matrix3f::identity()) {
-            const auto point = transform_matrix_ * Vector2f(x, y).xy1();
-            x = static_cast<int>(point.x);
-            y = static_cast<int>(point.y);
-
-            // 重新检查，防止变换后超出范围
-            if (x < 0 || x >= width_ || y < 0 || y >= height_) {
-                return;
-            }
+        // 不透明时混合结果就是颜色本身
+        if (color.a == 1.0f) {
+            frame_buffer_->set_pixel(x, y, vector_to_color(color));
+            return;
         }
 
         // 颜色混合
-        const auto bg_color = color_to_vector(frame_buffer_->get_pixel(x, y));
-        const auto alpha = color.a;
-        const auto new_color = color * alpha + bg_color * (1 - alpha);
+        const auto source = make_blend_source(color, global_options_.blend_mode);
+        const auto new_color = blend_pixel(frame_buffer_->get_pixel(x, y), source);
 
         // 将新颜色写入帧缓冲区
-        frame_buffer_->set_pixel(x, y, vector_to_color(new_color));
+        frame_buffer_->set_pixel(x, y, new_color);
     }
 
     void draw_pixel(int x, int y, uint32_t color) { draw_pixel(x, y, color_to_vector(color)); }
 
+    // 绘制第 y 行的 [x0, x1)
+    // 只裁剪一次，不透明时直接写入整段像素，半透明时使用 SIMD 内核整段混合
+    // 结果与逐个调用 draw_pixel 一致
+    void draw_span(int y, int x0, int x1, const Color &color);
+
+    // 填充矩形区域 bounds，结果与逐行调用 draw_span 一致
+    void draw_rect(const Bounds &bounds, const Color &color);
+
     // 保存到文件
+    // 根据扩展名选择格式（.png、.qoi，其他为 .bmp）
     void save(const std::string &filename) {
         if (frame_buffer_) {
-            frame_buffer_->save_bmp(filename.c_str());
+            image_encoder_.save(*frame_buffer_, filename);
         }
     }
 
-    // 获取帧缓冲区
+    // 设置保存 PNG 时的过滤方式和压缩等级
+    void set_png_options(const PngOptions &options) { image_encoder_.set_png_options(options); }
+
+    // 获取当前帧的快照，不复制像素
+    // 之后的渲染不会修改快照，持有快照的一方用完后释放即可
+    [[nodiscard]] Frame get_frame() const { return frame_buffer_; }
+
+    // 当前帧的版本
+    [[nodiscard]] uint64_t get_frame_version() const { return frame_version_; }
+
+    // 获取帧缓冲区的副本
     [[nodiscard]] Buffer get_frame_buffer() const {
         if (frame_buffer_) {
             return frame_buffer_->save_to_buffer();
@@ -160,144 +338,190 @@ class RenderCore::RenderEngine {
         return {};
     }
 
+    // 编辑接口
+    // 添加、插入、删除、修改图元，设置画笔选项、全局选项，获取图元快照
+    // 这些接口是线程安全的，可以与渲染并发调用
+    // 渲染、取帧、保存、清空等其他接口需要调用者保证同一时间只有一个线程调用
+    // 添加、插入、修改图元时按值接收图元，传入右值时移动而不复制
+
     // 绘制图元
-    int add_primitive(const Primitive &primitive) {
-        if (!frame_buffer_) {
+    int add_primitive(Primitive primitive) {
+        std::lock_guard lock(edit_mutex_);
+        if (!edit_.initialized) {
             return -1;
         }
-        need_render_ = true;
-        primitives_.push_back(primitive);
-        return primitives_.size() - 1;
+        begin_edit();
+        edit_.primitives.push_back(std::move(primitive));
+        return static_cast<int>(edit_.primitives.size() - 1);
     }
 
     // 插入图元
-    void insert_primitive(const Primitive &primitive, size_t index) {
-        if (!frame_buffer_) {
+    void insert_primitive(Primitive primitive, size_t index) {
+        std::lock_guard lock(edit_mutex_);
+        if (!edit_.initialized) {
             return;
         }
-        need_render_ = true;
-        if (index < primitives_.size()) {
-            primitives_.insert(primitives_.begin() + index, primitive);
-        } else {
-            primitives_.push_back(primitive);
+        begin_edit();
+        if (index < edit_.primitives.size()) {
+            // 插入到已有的图元之间
+            record_edit(PrimitiveEdit::Type::INSERT, index, is_state_primitive(primitive));
         }
+        edit_.primitives.insert(index, std::move(primitive));
     }
 
     // 移除图元
     void remove_primitive(size_t index) {
-        if (!frame_buffer_) {
+        std::lock_guard lock(edit_mutex_);
+        if (!edit_.initialized) {
             return;
         }
-        need_render_ = true;
-        if (index < primitives_.size()) {
-            primitives_.erase(primitives_.begin() + index);
+        begin_edit();
+        if (index < edit_.primitives.size()) {
+            record_edit(PrimitiveEdit::Type::REMOVE, index,
+                is_state_primitive(edit_.primitives[index]));
+            edit_.primitives.erase(index);
         }
     }
 
     // 修改图元
-    void modify_primitive(size_t index, const Primitive &primitive) {
-        if (!frame_buffer_) {
+    void modify_primitive(size_t index, Primitive primitive) {
+        std::lock_guard lock(edit_mutex_);
+        if (!edit_.initialized) {
             return;
         }
-        need_render_ = true;
-        if (index < primitives_.size()) {
-            primitives_[index] = primitive;
+        begin_edit();
+        if (index < edit_.primitives.size()) {
+            record_edit(PrimitiveEdit::Type::MODIFY, index,
+                is_state_primitive(edit_.primitives[index]) || is_state_primitive(primitive));
+            edit_.primitives.replace(index, std::move(primitive));
         }
     }
 
-    // 获取图元
-    [[nodiscard]] std::vector<std::reference_wrapper<const Primitive>> get_primitives() const {
-        return {primitives_.begin(), primitives_.end()};
+    // 图元数量
+    [[nodiscard]] size_t get_primitive_count() const {
+        std::lock_guard lock(edit_mutex_);
+        return edit_.primitives.size();
+    }
+
+    // 获取图元的快照
+    // 快照不可变，之后的编辑不会影响已经取得的快照，遍历时不需要持有任何锁
+    [[nodiscard]] std::shared_ptr<const PrimitiveList> get_primitives() const {
+        std::lock_guard lock(edit_mutex_);
+        return publish_snapshot();
+    }
+
+    // 锁定编辑状态，用于把一批编辑作为一个整体应用
+    // 持有期间其他线程不能编辑图元，渲染也会等待这批编辑完成
+    [[nodiscard]] std::unique_lock<std::recursive_mutex> lock_edits() const {
+        return std::unique_lock(edit_mutex_);
     }
 
     // 设置画笔选项
     void set_pen_options(const PenOptions &options) { add_primitive(options); }
 
-    // 应用变换矩阵
-    // 对于能在栅格化前应用变换矩阵的图元，直接应用变换矩阵
-    template <typename T>
-    void apply_transform(T &t) {
-        if constexpr (can_apply_transform_matrix_v<T>) {
-            apply_transform_matrix(t, transform_matrix_);
-            transform_matrix_ = Matrix3f::identity();
-        }
+    // 渲染
+    bool render();
+
+   private:
+    // 画笔选项和变换会影响之后的图元，修改它们需要重绘整帧
+    static bool is_state_primitive(const Primitive &primitive) {
+        return std::holds_alternative<PenOptions>(primitive) ||
+               std::holds_alternative<Transform>(primitive);
     }
 
-    // 渲染
-    bool render() {
-        if (!frame_buffer_) {
-            return false;
+    // 开始编辑，需要持有 edit_mutex_
+    // 已发布的快照失效，释放引擎对它的引用，没有读者持有时可以直接修改分块
+    void begin_edit() {
+        edit_.need_render = true;
+        edit_.snapshot.reset();
+    }
+
+    // 记录对已有图元的编辑，需要持有 edit_mutex_
+    void record_edit(PrimitiveEdit::Type type, size_t index, bool state) {
+        // 重绘整帧时不需要记录
+        if (edit_.full_redraw) {
+            return;
         }
-        if (!need_render_) {
-            return true;
+        if (edit_.edits.size() >= max_pending_edits) {
+            edit_.full_redraw = true;
+            edit_.edits.clear();
+            return;
         }
-        fill_with_background_color();
-        // 重置画笔选项
-        pen_options_ = {};
-
-        // 复制图元
-        render_primitives_ = std::list<Primitive>(primitives_.begin(), primitives_.end());
-        for (auto primitive : render_primitives_) {
-            // 应用变换矩阵
-            // 对于能在栅格化前应用变换矩阵的图元，直接对原始图元应用变换矩阵
-            // 对于不能在栅格化前应用变换矩阵的图元，先保存变换矩阵，在栅格化时通过draw_pixel应用变换矩阵
-            std::visit(
-                [this](auto &prim) {
-                    using T = std::decay_t<decltype(prim)>;
-                    if constexpr (std::is_same_v<T, Transform>) {
-                        make_transform(prim);
-                    } else {
-                        apply_transform(prim);
-                    }
-                },
-                primitive);
-            // 裁剪
-            // 对于需要裁剪的图元，进行裁剪
-            // 裁剪后的图元会替换原始图元
-            // 裁剪后的图元可能是空的 monostate
-            clip(primitive);
-            // 开始进行栅格化
-            // 对于不同的图元，使用不同的栅格化算法
-            // 栅格化后的图元会根据画笔选项进行绘制
-            // 如果是画笔选项，只更新画笔选项
-            // 画笔选项会影响接下来的图元直到下一个画笔选项
-            std::visit(
-                [this](const auto &prim) {
-                    using T = std::decay_t<decltype(prim)>;
-                    if constexpr (std::is_same_v<T, Line>) {
-                        draw_line(prim);
-                    } else if constexpr (std::is_same_v<T, Circle>) {
-                        draw_circle(prim);
-                    } else if constexpr (std::is_same_v<T, Arc>) {
-                        draw_arc(prim);
-                    } else if constexpr (std::is_same_v<T, Rectangle>) {
-                        draw_rectangle(prim);
-                    } else if constexpr (std::is_same_v<T, Polygon>) {
-                        draw_polygon(prim);
-                    } else if constexpr (std::is_same_v<T, Fill>) {
-                        draw_fill(prim);
-                    } else if constexpr (std::is_same_v<T, PenOptions>) {
-                        pen_options_ = prim;
-                    } else if constexpr (std::is_same_v<T, BezierCurve>) {
-                        draw_bezier_curve(prim);
-                    } else if constexpr (std::is_same_v<T, BsplineCurve>) {
-                        draw_bspline_curve(prim);
-                    };
-                    // 重置变换矩阵
-                    // 变换矩阵只对下一个图元有效
-                    if constexpr (!std::is_same_v<T, Transform> && !std::is_same_v<T, PenOptions>) {
-                        transform_matrix_ = Matrix3f::identity();
-                    }
-                },
-                primitive);
+        edit_.edits.push_back({type, index, state});
+    }
+
+    // 发布图元快照，需要持有 edit_mutex_
+    // 两次编辑之间的读者共享同一个快照
+    [[nodiscard]] std::shared_ptr<const PrimitiveList> publish_snapshot() const {
+        if (!edit_.snapshot) {
+            edit_.snapshot = std::make_shared<const PrimitiveList>(edit_.primitives);
         }
-        need_render_ = false;
-        return true;
+        return edit_.snapshot;
     }
 
-   private:
+    // 在锁内取得图元快照、全局选项和编辑记录，再把编辑记录应用到 render_items_
+    // 返回是否需要渲染
+    bool take_edits();
+
+    // 把一次编辑应用到 render_items_
+    void apply_edit(const PrimitiveEdit &edit);
+
+    // 同步各线程的绘制上下文的画布大小和全局选项
+    void sync_tile_engines();
+
+    // 保证 frame_buffer_ 没有被快照引用，绘制前调用
+    // 被引用时换到空闲的缓冲区，增量渲染时复制当前帧的内容
+    void acquire_frame_buffer();
+
+    // 为尚未绘制的追加图元生成渲染项，并记录绘制时的画笔选项、变换矩阵
+    void append_render_items();
+
+    // 对 [begin, render_items_.size()) 中标记为 dirty 的渲染项重新变换、裁剪并计算包围盒
+    // 返回重新准备的渲染项下标
+    std::vector<size_t> prepare_render_items(size_t begin);
+
+    // 计算渲染项的包围盒，渲染项还没有派生几何时计算派生几何
+    void prepare_render_item(RenderItem &item, const Primitive &primitive);
+
+    // 图元是否需要变换、裁剪或采样
+    [[nodiscard]] bool has_derived_geometry(
+        const RenderItem &item, const Primitive &primitive) const;
+
+    // 将图元变换、裁剪，并计算曲线采样点
+    std::shared_ptr<const DerivedGeometry> derive_geometry(
+        const RenderItem &item, const Primitive &primitive);
+
+    // 添加脏区域，与已有的脏区域合并，保证互不重叠
+    void add_dirty_region(const Bounds &region);
+
+    // 清空并重绘所有脏区域
+    void redraw_dirty_regions();
+
+    // 计算渲染项在屏幕空间的包围盒（保守估计）
+    [[nodiscard]] Bounds render_item_bounds(
+        const RenderItem &item, const Primitive &primitive) const;
+
+    // 第 index 个渲染项要绘制的图元，只能在渲染过程中调用
+    [[nodiscard]] const Primitive &render_item_primitive(size_t index) const {
+        const auto &item = render_items_[index];
+        return item.geometry && item.geometry->modified ? *item.geometry->modified
+                                                        : (*primitives_)[index];
+    }
+
+    // 在 region 内绘制 [begin, end) 的渲染项
+    void rasterize_items(size_t begin, size_t end, const Bounds &region);
+
+    // 把第 index 个渲染项放入它经过的分块，分块共 tiles_x 列，覆盖 region
+    void bin_render_item(size_t index, const Bounds &region, int tiles_x);
+
+    // 分块并行绘制 [begin, end) 的渲染项，区间内不能包含 barrier
+    void rasterize_items_tiled(size_t begin, size_t end, const Bounds &region);
+
+    // 使用渲染项记录的状态绘制单个渲染项
+    void rasterize_item(const RenderItem &item, const Primitive &primitive);
+
     // 绘制点
-    // 线型线宽的控制也在这里实现
+    // 线型的控制也在这里实现，线宽大于 1 的线条由 draw_stroke 绘制
     // index 用于控制虚线、点线、点划线等
     void draw_point(int x, int y, int index = -1);
 
@@ -310,11 +534,15 @@ class RenderCore::RenderEngine {
     // 绘制圆弧
     void draw_arc(const Arc &arc);
 
+    // 绘制椭圆，内部按行填充
+    void draw_ellipse(const Ellipse &ellipse);
+
     // 绘制矩形
     void draw_rectangle(const Rectangle &rectangle);
 
     // 绘制多边形
-    void draw_polygon(const Polygon &polygon);
+    // convex 为 true 时走凸多边形的快速路径，凸性由调用者预先求出，见 DerivedGeometry::convex
+    void draw_polygon(const Polygon &polygon, bool convex = false);
 
     // 填充
     void draw_fill(const Fill &fill);
@@ -325,11 +553,23 @@ class RenderCore::RenderEngine {
     // 变换
     void make_transform(const Transform &transform);
 
-    // 贝塞尔曲线
-    void draw_bezier_curve(const BezierCurve &curve);
+    // 贝塞尔曲线采样
+    void sample_bezier_curve(const BezierCurve &curve, std::vector<Point> &samples) const;
+
+    // B样条曲线采样
+    void sample_bspline_curve(const BsplineCurve &curve, std::vector<Point> &samples) const;
 
-    // B样条曲线
-    void draw_bspline_curve(const BsplineCurve &curve);
+    // 把曲线采样点分组
+    static void chunk_curve_samples(
+        const std::vector<Point> &samples, std::vector<CurveChunk> &chunks);
+
+    // 绘制曲线采样点
+    void draw_curve_samples(
+        const std::vector<Point> &samples, const std::vector<CurveChunk> &chunks);
+
+    // 宽线描边，线宽大于 1 的线段、折线、曲线和圆弧都由此绘制，closed 为 true 时首尾相连
+    void draw_stroke(std::span<const Point> points, bool closed);
+    void draw_stroke(std::span<const Vector2d> points, bool closed);
 
    private:
     // DDA 算法绘制线段
@@ -350,6 +590,12 @@ class RenderCore::RenderEngine {
     // 扫描线算法绘制多边形
     void draw_polygon_scanline(const Polygon &polygon);
 
+    // 凸多边形的快速路径，每行只有左右两条边
+    void draw_polygon_convex(const Polygon &polygon);
+
+    // 以画笔颜色按非零环绕规则填充描边的轮廓
+    void fill_stroke(ScanlineRasterizer &rasterizer);
+
     // 种子填充算法填充多边形
     void fill_polygon_seedfill(const Fill &fill);
 
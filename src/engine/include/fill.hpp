@@ -11,9 +11,17 @@ namespace RenderCore {
 
 struct Fill {
     Point seed;
+    // 连通方式：四连通只向上下左右扩展，八连通还会穿过对角相邻的像素
+    enum class Connectivity {
+        FOUR,   // 四连通
+        EIGHT,  // 八连通
+    } connectivity{Connectivity::FOUR};
 };
 
-inline Fill make_fill(const Point &seed) { return Fill{seed}; }
+inline Fill make_fill(
+    const Point &seed, Fill::Connectivity connectivity = Fill::Connectivity::FOUR) {
+    return Fill{seed, connectivity};
+}
 
 }  // namespace RenderCore
 
@@ -0,0 +1,75 @@
+#ifndef RENDERENGINE_FRAME_ENCODER_HPP
+#define RENDERENGINE_FRAME_ENCODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap.hpp"
+
+namespace RenderCore {
+
+// 帧类型
+enum class FrameType : uint8_t {
+    KEY = 0,    // 关键帧，包含完整的像素数据
+    DELTA = 1,  // 差量帧，只包含相对基准帧改变的分块
+};
+
+// 编码后的帧格式（小端序）：
+// 帧头 32 字节：
+//   u8  类型（FrameType）
+//   u8  保留，为 0
+//   u16 分块大小
+//   u32 宽度
+//   u32 高度
+//   u64 帧版本
+//   u64 基准帧版本，关键帧为 0
+//   u32 分块数，关键帧为 0
+// 关键帧：紧接宽度 * 高度 * 4 字节的 RGBA 像素
+// 差量帧：紧接每个分块的 u32 分块序号（按行优先编号）和分块内的 RGBA 像素（逐行，边缘分块被裁剪）
+class FrameEncoder {
+   public:
+    using Buffer = std::vector<uint8_t>;
+
+    static constexpr size_t header_size = 32;
+    static constexpr int default_tile_size = 32;
+
+   private:
+    int tile_size_;
+    // 编码结果，每次编码时复用
+    Buffer buffer_;
+
+   public:
+    explicit FrameEncoder(int tile_size = default_tile_size) : tile_size_(tile_size) {}
+
+    [[nodiscard]] int tile_size() const { return tile_size_; }
+
+    // 编码关键帧
+    // 返回的缓冲区在下一次编码前有效
+    const Buffer &encode_key(const Bitmap &frame, uint64_t version);
+
+    // 编码 frame 相对 base 的差量帧，两者大小需相同
+    // 返回的缓冲区在下一次编码前有效
+    const Buffer &encode_delta(
+        const Bitmap &base, uint64_t base_version, const Bitmap &frame, uint64_t version);
+
+   private:
+    void write_header(FrameType type, const Bitmap &frame, uint64_t version,
+        uint64_t base_version, uint32_t tile_count);
+};
+
+// 解码帧的结果
+struct DecodedFrame {
+    FrameType type{FrameType::KEY};
+    uint64_t version{0};
+    uint64_t base_version{0};
+    uint32_t tile_count{0};
+};
+
+// 将编码后的帧应用到 target 上，target 需与帧大小相同
+// 差量帧需在基准帧上应用，数据不完整或大小不符时返回 false
+bool decode_frame(Bitmap &target, const uint8_t *data, size_t size, DecodedFrame &result);
+
+}  // namespace RenderCore
+
+#endif  //RENDERENGINE_FRAME_ENCODER_HPP
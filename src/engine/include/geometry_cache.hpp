@@ -0,0 +1,172 @@
+#ifndef RENDERENGINE_GEOMETRY_CACHE_HPP
+#define RENDERENGINE_GEOMETRY_CACHE_HPP
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "bounds.hpp"
+#include "matrix.hpp"
+#include "options.hpp"
+#include "point.hpp"
+#include "primitive.hpp"
+
+namespace RenderCore {
+
+// 曲线采样点的分组，每组包含连续的若干条线段
+struct CurveChunk {
+    // 组内线段的包围盒
+    Bounds bounds;
+    // 组内第一条线段之前所有线段的步数之和
+    int steps{0};
+};
+
+// 图元的派生几何
+// 图元经过变换、裁剪后的结果、曲线的采样点和多边形的凸性，
+// 只取决于图元本身、变换矩阵和全局选项中的裁剪窗口、曲线偏差
+struct DerivedGeometry {
+    // 变换、裁剪后的图元，为空时绘制原始图元
+    std::optional<Primitive> modified;
+    // 曲线的采样点
+    std::vector<Point> samples;
+    // 曲线采样点的分组，分块绘制时跳过与分块不相交的组
+    std::vector<CurveChunk> chunks;
+    // 多边形是否为凸多边形，凸多边形不需要维护活性边表
+    bool convex{false};
+};
+
+class GeometryCache;
+
+}  // namespace RenderCore
+
+// 派生几何缓存
+// 以图元的内容和变换矩阵为键，内容相同的图元重新准备渲染项时（如重绘整帧）直接复用之前的结果
+// 渲染项与缓存共享派生几何，不再被任何渲染项引用的条目在每轮渲染结束时删除
+// 图元被修改后内容不同，不会命中旧的条目；裁剪窗口或曲线偏差改变时清空整个缓存
+class RenderCore::GeometryCache {
+   public:
+    // 键是图元的类型、各字段和变换矩阵按顺序编码成的整数序列，浮点数按位编码
+    using Key = std::vector<uint32_t>;
+
+   private:
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return std::hash<std::string_view>{}(std::string_view(
+                reinterpret_cast<const char *>(key.data()), key.size() * sizeof(uint32_t)));
+        }
+    };
+
+    std::unordered_map<Key, std::shared_ptr<const DerivedGeometry>, KeyHash> entries_;
+    // 生成缓存内容时的裁剪窗口和曲线偏差
+    Key options_;
+
+   public:
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+
+    static Key make_key(const Primitive &primitive, const Matrix3f &transform_matrix) {
+        Key key;
+        key.push_back(static_cast<uint32_t>(primitive.index()));
+        std::visit([&key](const auto &prim) { encode(key, prim); }, primitive);
+        for (size_t i = 0; i < 3; i++) {
+            for (size_t j = 0; j < 3; j++) {
+                encode(key, transform_matrix[i][j]);
+            }
+        }
+        return key;
+    }
+
+    // 全局选项中影响派生几何的部分改变时清空缓存，每轮渲染开始时调用
+    void validate(const GlobalOptions &options) {
+        Key key;
+        encode(key, options.clip.enable);
+        if (options.clip.enable) {
+            encode(key, options.clip.algorithm);
+            key.push_back(static_cast<uint32_t>(options.clip.window.index()));
+            std::visit([&key](const auto &window) { encode(key, window); }, options.clip.window);
+        }
+        encode(key, options.curve_tolerance);
+        if (key != options_) {
+            entries_.clear();
+            options_ = std::move(key);
+        }
+    }
+
+    [[nodiscard]] std::shared_ptr<const DerivedGeometry> find(const Key &key) const {
+        const auto it = entries_.find(key);
+        return it == entries_.end() ? nullptr : it->second;
+    }
+
+    void insert(Key key, std::shared_ptr<const DerivedGeometry> geometry) {
+        entries_.insert_or_assign(std::move(key), std::move(geometry));
+    }
+
+    // 删除没有被渲染项引用的条目
+    void collect() {
+        std::erase_if(entries_, [](const auto &entry) { return entry.second.use_count() == 1; });
+    }
+
+    void clear() { entries_.clear(); }
+
+   private:
+    template <typename T>
+    static void encode(Key &key, const T &value) {
+        if constexpr (std::is_same_v<T, float>) {
+            key.push_back(std::bit_cast<uint32_t>(value));
+        } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+            key.push_back(static_cast<uint32_t>(value));
+        } else if constexpr (std::is_same_v<T, Point>) {
+            encode(key, value.x);
+            encode(key, value.y);
+        } else if constexpr (std::is_same_v<T, Line>) {
+            encode(key, value.p1);
+            encode(key, value.p2);
+            encode(key, value.algorithm);
+        } else if constexpr (std::is_same_v<T, Rectangle>) {
+            encode(key, value.top_left);
+            encode(key, value.bottom_right);
+        } else if constexpr (std::is_same_v<T, Fill>) {
+            encode(key, value.seed);
+            encode(key, value.connectivity);
+        } else if constexpr (std::is_same_v<T, CircleUseCenterRadius>) {
+            encode(key, value.center);
+            encode(key, value.radius);
+        } else if constexpr (std::is_same_v<T, ArcUseCenterRadiusAngle>) {
+            encode(key, value.center);
+            encode(key, value.radius);
+            encode(key, value.start_angle);
+            encode(key, value.end_angle);
+        } else if constexpr (std::is_same_v<T, Ellipse>) {
+            encode(key, value.center);
+            encode(key, value.radius_x);
+            encode(key, value.radius_y);
+        } else if constexpr (std::is_same_v<T, CircleUseThreePoints> ||
+                             std::is_same_v<T, ArcUseThreePoints>) {
+            encode(key, value.p1);
+            encode(key, value.p2);
+            encode(key, value.p3);
+        } else if constexpr (std::is_same_v<T, Circle> || std::is_same_v<T, Arc>) {
+            key.push_back(static_cast<uint32_t>(value.index()));
+            std::visit([&key](const auto &v) { encode(key, v); }, value);
+        } else if constexpr (std::is_same_v<T, BsplineCurve>) {
+            encode(key, value.control_points);
+            encode(key, value.knots);
+        } else if constexpr (std::is_base_of_v<std::vector<Point>, T> ||
+                             std::is_same_v<T, std::vector<float>>) {
+            // 多边形、贝塞尔曲线和节点向量，先写入长度
+            key.push_back(static_cast<uint32_t>(value.size()));
+            for (const auto &element : value) {
+                encode(key, element);
+            }
+        }
+        // 画笔选项、变换和空图元没有派生几何，只编码类型
+    }
+};
+
+#endif  //RENDERENGINE_GEOMETRY_CACHE_HPP
@@ -0,0 +1,110 @@
+#ifndef RENDERENGINE_IMAGE_ENCODER_HPP
+#define RENDERENGINE_IMAGE_ENCODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bitmap.hpp"
+
+namespace RenderCore {
+
+// 图像格式
+enum class ImageFormat {
+    BMP,
+    QOI,
+    PNG,
+};
+
+// PNG 行过滤方式
+enum class PngFilter : uint8_t {
+    NONE = 0,
+    SUB = 1,
+    UP = 2,
+    PAETH = 4,
+};
+
+struct PngOptions {
+    // 行过滤方式，界面类画面使用 UP 即可得到较好的压缩率
+    PngFilter filter{PngFilter::UP};
+    // 压缩等级
+    // 0 不压缩，1 只查找最近一次出现的匹配，之后每级多查找一个候选位置，最大为 9
+    int level{1};
+};
+
+// 根据名称（"bmp"、"qoi"、"png"）取得图像格式
+std::optional<ImageFormat> image_format_from_name(const std::string &name);
+
+// 根据文件扩展名取得图像格式，未知扩展名使用 BMP
+ImageFormat image_format_from_filename(const std::string &filename);
+
+// 图像格式的 MIME 类型
+const char *image_mime_type(ImageFormat format);
+
+// 图像编码器
+// 编码结果写入内部的缓冲区，多次编码时复用缓冲区和压缩用的工作内存
+class ImageEncoder {
+   public:
+    using Buffer = std::vector<uint8_t>;
+
+   private:
+    PngOptions png_options_;
+    // 编码结果
+    Buffer buffer_;
+    // PNG 过滤后的行数据
+    Buffer filtered_;
+    // deflate 的哈希表和匹配链
+    std::vector<uint32_t> head_;
+    std::vector<uint32_t> prev_;
+    // deflate 的位输出
+    uint64_t bits_{0};
+    int bit_count_{0};
+
+   public:
+    ImageEncoder() = default;
+
+    explicit ImageEncoder(const PngOptions &png_options) : png_options_(png_options) {}
+
+    void set_png_options(const PngOptions &png_options) { png_options_ = png_options; }
+
+    [[nodiscard]] const PngOptions &get_png_options() const { return png_options_; }
+
+    // 编码为指定格式
+    // 返回的缓冲区在下一次编码前有效
+    const Buffer &encode(const Bitmap &bitmap, ImageFormat format);
+
+    // 与 Bitmap::save_bmp 的输出相同
+    const Buffer &encode_bmp(const Bitmap &bitmap, bool with_alpha = false);
+
+    const Buffer &encode_qoi(const Bitmap &bitmap);
+
+    const Buffer &encode_png(const Bitmap &bitmap);
+
+    // 取出编码结果，不复制数据，之后的编码重新分配缓冲区
+    Buffer take_buffer() { return std::move(buffer_); }
+
+    // 交还之前取出的缓冲区，之后的编码复用它的容量
+    void reuse_buffer(Buffer &&buffer) { buffer_ = std::move(buffer); }
+
+    // 根据扩展名选择格式并保存到文件
+    bool save(const Bitmap &bitmap, const std::string &filename);
+
+   private:
+    // 以 zlib 格式压缩，追加到 buffer_
+    void deflate(const uint8_t *data, size_t size);
+
+    void deflate_stored(const uint8_t *data, size_t size);
+
+    void deflate_fixed(const uint8_t *data, size_t size);
+
+    void put_bits(uint32_t value, int count);
+
+    void flush_bits();
+};
+
+}  // namespace RenderCore
+
+#endif  //RENDERENGINE_IMAGE_ENCODER_HPP
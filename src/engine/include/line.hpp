@@ -5,6 +5,10 @@
 #ifndef RENDERENGINE_LINE_HPP
 #define RENDERENGINE_LINE_HPP
 
+#include <cstdint>
+#include <utility>
+
+#include "bounds.hpp"
 #include "point.hpp"
 
 namespace RenderCore {
@@ -23,6 +27,34 @@ inline Line make_line(const Point &p1, const Point &p2,
     return RenderCore::Line{p1, p2, algorithm};
 }
 
+// 直线的步进规律
+// 从起点出发每步沿主方向移动 1 像素，前 k 步沿次方向共移动 (2k * minor + bias) / (2 * major) 像素
+// Bresenham 算法和中点算法都满足这一规律，只是 bias 不同
+// 由此可以直接求出第 k 步的位置，分块绘制时只需遍历落在绘制区域内的步数
+struct LineStepper {
+    Point start;
+    int sx, sy;  // 前进方向
+    bool x_major;
+    int64_t major, minor, bias;
+
+    // 前 k 步沿次方向移动的像素数
+    [[nodiscard]] int64_t moves(int64_t k) const {
+        return minor == 0 ? 0 : (2 * k * minor + bias) / (2 * major);
+    }
+
+    // 第 k 步的像素位置
+    [[nodiscard]] Point at(int64_t k) const {
+        const auto m = static_cast<int>(moves(k));
+        const auto n = static_cast<int>(k);
+        return x_major ? Point{start.x + sx * n, start.y + sy * m}
+                       : Point{start.x + sx * m, start.y + sy * n};
+    }
+
+    // 第 first 到 last 步中位置落在 bounds 内的步数范围，first > last 时为空
+    [[nodiscard]] std::pair<int64_t, int64_t> clip(
+        const Bounds &bounds, int64_t first, int64_t last) const;
+};
+
 }  // namespace RenderCore
 
 #endif  // RENDERENGINE_LINE_HPP
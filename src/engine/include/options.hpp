@@ -5,6 +5,9 @@
 #ifndef RENDERENGINE_OPTIONS_HPP
 #define RENDERENGINE_OPTIONS_HPP
 
+#include <cstdint>
+
+#include "blend.hpp"
 #include "clip.hpp"
 #include "color.hpp"
 
@@ -27,14 +30,49 @@ struct PenOptions {
     } type{LineType::SOLID};
     // 虚线间隔
     int dash{5};
+    // 线宽大于 1 时，线段端点的样式
+    enum class LineCap {
+        BUTT,    // 平头，在端点处截断
+        SQUARE,  // 方头，向外延伸半个线宽
+        ROUND,   // 圆头
+    } cap{LineCap::SQUARE};
+    // 线宽大于 1 时，折线拐角的样式
+    enum class LineJoin {
+        MITER,  // 尖角，过长时改为斜角
+        BEVEL,  // 斜角
+        ROUND,  // 圆角
+    } join{LineJoin::MITER};
+    // 多边形的填充规则，决定自相交多边形哪些部分属于内部
+    enum class FillRule {
+        EVEN_ODD,  // 奇偶规则
+        NON_ZERO,  // 非零环绕规则
+    } fill_rule{FillRule::EVEN_ODD};
 };
 
+// 线型的 16 位循环模式，从低位开始，每位对应 dash 个像素，为 1 的位绘制
+constexpr uint16_t line_type_pattern(PenOptions::LineType type) {
+    switch (type) {
+        case PenOptions::LineType::DASH:
+            return 0b1100'1100'1100'1100;
+        case PenOptions::LineType::DOT:
+            return 0b1000'1000'1000'1000;
+        case PenOptions::LineType::DASH_DOT:
+            return 0b1111'1010'1111'1010;
+        default:
+            return 0xFFFF;
+    }
+}
+
 // 全局选项
 struct GlobalOptions {
     // 背景色
     Color background_color{Colors::Black};
     // 裁剪窗口
     Clip clip;
+    // 半透明颜色的混合模式
+    BlendMode blend_mode{BlendMode::FLOAT};
+    // 曲线折线化时允许的最大偏差（像素）
+    float curve_tolerance{0.5f};
 };
 
 }  // namespace RenderCore
@@ -5,7 +5,9 @@
 #ifndef RENDERENGINE_POLYGON_HPP
 #define RENDERENGINE_POLYGON_HPP
 
+#include <cstdint>
 #include <initializer_list>
+#include <utility>
 #include <vector>
 
 #include "point.hpp"
@@ -35,5 +37,70 @@ inline Polygon make_polygon(const std::vector<Point>& points) {
     return Polygon{points};
 };
 
+// 是否为面积不为 0 的凸多边形
+// 重复的顶点和同向共线的顶点不影响判断；自相交（如五角星）或有折返的多边形不是凸多边形
+inline bool is_convex_polygon(const Polygon& polygon) {
+    using Edge = std::pair<int64_t, int64_t>;
+    const size_t n = polygon.size();
+    // 转向一致，且边的方向只绕一圈：x、y 分量的符号各自最多改变两次
+    int turn = 0;
+    int x_changes = 0;
+    int y_changes = 0;
+    Edge first{0, 0};
+    Edge last{0, 0};
+    // 第一个和上一个不为 0 的分量
+    int64_t first_x = 0;
+    int64_t first_y = 0;
+    int64_t last_x = 0;
+    int64_t last_y = 0;
+    const auto count_change = [](int64_t value, int64_t& last_value, int& changes) {
+        if (value != 0) {
+            if (last_value != 0 && (value > 0) != (last_value > 0)) {
+                changes++;
+            }
+            last_value = value;
+        }
+    };
+    // 相邻两条边的转向，同向共线时不计，折返时不是凸多边形
+    const auto check_turn = [&turn](const Edge& a, const Edge& b) {
+        const int64_t cross = a.first * b.second - a.second * b.first;
+        if (cross == 0) {
+            return a.first * b.first + a.second * b.second > 0;
+        }
+        const int sign = cross > 0 ? 1 : -1;
+        if (turn != 0 && sign != turn) {
+            return false;
+        }
+        turn = sign;
+        return true;
+    };
+    for (size_t i = 0; i < n; i++) {
+        const auto& p = polygon[i];
+        const auto& q = polygon[(i + 1) % n];
+        // 跳过长度为 0 的边
+        if (p == q) {
+            continue;
+        }
+        const Edge edge{static_cast<int64_t>(q.x) - p.x, static_cast<int64_t>(q.y) - p.y};
+        if (first == Edge{0, 0}) {
+            first = edge;
+        } else if (!check_turn(last, edge)) {
+            return false;
+        }
+        first_x = first_x != 0 ? first_x : edge.first;
+        first_y = first_y != 0 ? first_y : edge.second;
+        count_change(edge.first, last_x, x_changes);
+        count_change(edge.second, last_y, y_changes);
+        last = edge;
+    }
+    if (first == Edge{0, 0} || !check_turn(last, first)) {
+        return false;
+    }
+    // 首尾相接处的符号变化
+    count_change(first_x, last_x, x_changes);
+    count_change(first_y, last_y, y_changes);
+    return turn != 0 && x_changes <= 2 && y_changes <= 2;
+}
+
 }  // namespace RenderCore
 #endif
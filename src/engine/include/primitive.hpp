@@ -18,11 +18,20 @@
 namespace RenderCore {
 
 // 图元
-// 可以是线段、圆、圆弧、矩形、多边形、填充、画笔选项、变换等
+// 可以是线段、圆、圆弧、矩形、多边形、填充、画笔选项、变换、曲线、椭圆等
 // 也可以是空的 monostate
 using Primitive = std::variant<Line, Circle, Arc, Rectangle, Polygon, Fill, PenOptions, Transform,
-    BezierCurve, BsplineCurve, std::monostate>;
+    BezierCurve, BsplineCurve, Ellipse, std::monostate>;
 
-}
+// 对图元应用变换矩阵
+// 线段、多边形、填充和曲线直接变换坐标；矩形、圆、圆弧、椭圆变换后可能不再是原来的形状，
+// 换成等价的图元：不再平行于坐标轴的矩形变为多边形，椭圆变为折线化的多边形，
+// 圆和圆弧在相似变换下仍为圆和圆弧，否则变为由三次贝塞尔曲线段拼接而成的 B 样条曲线
+template <>
+struct TransformMatrixApply<Primitive> : std::true_type {
+    void operator()(Primitive &primitive, const Matrix3f &transform) const;
+};
+
+}  // namespace RenderCore
 
 #endif  //RENDERENGINE_PRIMITIVE_HPP
@@ -0,0 +1,197 @@
+#ifndef RENDERENGINE_PRIMITIVE_LIST_HPP
+#define RENDERENGINE_PRIMITIVE_LIST_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "primitive.hpp"
+
+namespace RenderCore {
+
+// 分块存储的图元列表
+// 复制列表时只复制各分块的指针，分块在多个列表之间共享，修改时才复制被修改的分块（写时复制）
+// 渲染引擎把正在编辑的列表复制一份作为不可变的快照，交给读者和渲染过程
+// 之后的编辑不会影响已经发布的快照
+class PrimitiveList {
+   public:
+    using Chunk = std::vector<Primitive>;
+    // 分块超过此大小时拆分成两块
+    static constexpr size_t max_chunk_size = 256;
+
+   private:
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    // 每个分块第一个图元的下标
+    std::vector<size_t> offsets_;
+    size_t size_{0};
+    // 版本，每次修改时递增
+    uint64_t version_{0};
+
+   public:
+    class const_iterator {
+        const PrimitiveList *list_{nullptr};
+        size_t chunk_{0};
+        size_t offset_{0};
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Primitive;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Primitive *;
+        using reference = const Primitive &;
+
+        const_iterator() = default;
+
+        const_iterator(const PrimitiveList *list, size_t chunk, size_t offset)
+            : list_(list), chunk_(chunk), offset_(offset) {}
+
+        reference operator*() const { return (*list_->chunks_[chunk_])[offset_]; }
+
+        pointer operator->() const { return &**this; }
+
+        const_iterator &operator++() {
+            if (++offset_ == list_->chunks_[chunk_]->size()) {
+                chunk_++;
+                offset_ = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const const_iterator &other) const {
+            return chunk_ == other.chunk_ && offset_ == other.offset_;
+        }
+
+        bool operator!=(const const_iterator &other) const { return !(*this == other); }
+    };
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+    [[nodiscard]] uint64_t version() const { return version_; }
+
+    [[nodiscard]] const Primitive &operator[](size_t index) const {
+        const auto [chunk, offset] = locate(index);
+        return (*chunks_[chunk])[offset];
+    }
+
+    [[nodiscard]] const_iterator begin() const { return {this, 0, 0}; }
+
+    [[nodiscard]] const_iterator end() const { return {this, chunks_.size(), 0}; }
+
+    // 指向 index 处图元的迭代器，超出范围时返回 end()
+    [[nodiscard]] const_iterator iterator_at(size_t index) const {
+        if (index >= size_) {
+            return end();
+        }
+        const auto [chunk, offset] = locate(index);
+        return {this, chunk, offset};
+    }
+
+    void push_back(Primitive primitive) {
+        if (chunks_.empty() || chunks_.back()->size() >= max_chunk_size) {
+            offsets_.push_back(size_);
+            chunks_.push_back(std::make_shared<Chunk>());
+            chunks_.back()->reserve(max_chunk_size);
+        }
+        mutable_chunk(chunks_.size() - 1).push_back(std::move(primitive));
+        size_++;
+        version_++;
+    }
+
+    // 插入到 index 之前，超出范围时追加到末尾
+    void insert(size_t index, Primitive primitive) {
+        if (index >= size_) {
+            push_back(std::move(primitive));
+            return;
+        }
+        const auto [chunk, offset] = locate(index);
+        auto &target = mutable_chunk(chunk);
+        target.insert(target.begin() + static_cast<std::ptrdiff_t>(offset), std::move(primitive));
+        if (target.size() > max_chunk_size) {
+            // 后一半移到新的分块
+            const auto middle = target.begin() + static_cast<std::ptrdiff_t>(target.size() / 2);
+            auto tail = std::make_shared<Chunk>(
+                std::make_move_iterator(middle), std::make_move_iterator(target.end()));
+            target.erase(middle, target.end());
+            chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(chunk) + 1,
+                std::move(tail));
+            offsets_.insert(offsets_.begin() + static_cast<std::ptrdiff_t>(chunk) + 1, 0);
+        }
+        size_++;
+        version_++;
+        update_offsets(chunk);
+    }
+
+    void erase(size_t index) {
+        if (index >= size_) {
+            return;
+        }
+        const auto [chunk, offset] = locate(index);
+        auto &target = mutable_chunk(chunk);
+        target.erase(target.begin() + static_cast<std::ptrdiff_t>(offset));
+        if (target.empty()) {
+            chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(chunk));
+            offsets_.erase(offsets_.begin() + static_cast<std::ptrdiff_t>(chunk));
+        }
+        size_--;
+        version_++;
+        update_offsets(chunk);
+    }
+
+    // 替换 index 处的图元
+    void replace(size_t index, Primitive primitive) {
+        if (index >= size_) {
+            return;
+        }
+        const auto [chunk, offset] = locate(index);
+        mutable_chunk(chunk)[offset] = std::move(primitive);
+        version_++;
+    }
+
+    void clear() {
+        chunks_.clear();
+        offsets_.clear();
+        size_ = 0;
+        version_++;
+    }
+
+   private:
+    // 下标所在的分块和分块内的偏移
+    [[nodiscard]] std::pair<size_t, size_t> locate(size_t index) const {
+        const auto it = std::upper_bound(offsets_.begin(), offsets_.end(), index);
+        const auto chunk = static_cast<size_t>(it - offsets_.begin()) - 1;
+        return {chunk, index - offsets_[chunk]};
+    }
+
+    // 取得可以修改的分块，分块被其他列表共享时先复制一份
+    // 引用计数为 1 时只有当前列表持有，其他线程无法再取得它，可以直接修改
+    Chunk &mutable_chunk(size_t chunk) {
+        auto &pointer = chunks_[chunk];
+        if (pointer.use_count() > 1) {
+            pointer = std::make_shared<Chunk>(*pointer);
+        }
+        return *pointer;
+    }
+
+    // 重新计算 from 之后的分块的起始下标
+    void update_offsets(size_t from) {
+        for (size_t i = from; i < chunks_.size(); i++) {
+            offsets_[i] = i == 0 ? 0 : offsets_[i - 1] + chunks_[i - 1]->size();
+        }
+    }
+};
+
+}  // namespace RenderCore
+
+#endif  //RENDERENGINE_PRIMITIVE_LIST_HPP
@@ -0,0 +1,288 @@
+#ifndef RENDERENGINE_SCANLINE_HPP
+#define RENDERENGINE_SCANLINE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "bounds.hpp"
+#include "options.hpp"
+#include "point.hpp"
+
+namespace RenderCore {
+class ScanlineRasterizer;
+}
+
+// 扫描线多边形填充
+// 边从传入的内存池分配，只遍历边覆盖的行，活性边表按 x 有序增量维护
+// 边的 x 用整数部分加余数的定点数表示，逐行递推没有累计误差
+// 像素中心在多边形内时填充：每行 [ceil(左交点), ceil(右交点))，边的 y 范围为下闭上开
+// 与矩形一样左闭右开，相邻多边形公共边上的像素只属于其中一个
+class RenderCore::ScanlineRasterizer {
+   public:
+    using FillRule = PenOptions::FillRule;
+
+   private:
+    struct Edge {
+        // 边覆盖的行 [y_begin, y_end)
+        int64_t y_begin;
+        int64_t y_end;
+        // 当前行的交点 x = x + remainder / denominator，0 <= remainder < denominator
+        int64_t x;
+        int64_t remainder;
+        // 每行 x 的增量 step + step_remainder / denominator
+        int64_t step;
+        int64_t step_remainder;
+        int64_t denominator;
+        // 向下（y 增大）为 1，向上为 -1
+        int winding;
+    };
+
+    std::pmr::vector<Edge> edges_;
+
+   public:
+    // 亚像素坐标的精度，add_subpixel_edge 的坐标以 1 / subpixel_scale 像素为单位
+    static constexpr int64_t subpixel_scale = 16;
+    // 亚像素坐标的范围（像素），保证中间结果不会溢出
+    static constexpr int64_t max_subpixel_coordinate = int64_t{1} << 24;
+
+    explicit ScanlineRasterizer(std::pmr::memory_resource *resource) : edges_(resource) {}
+
+    void reserve(size_t count) { edges_.reserve(count); }
+
+    // 添加一条边，水平边不影响填充，直接忽略
+    void add_edge(const Point &start, const Point &end) {
+        add_scaled_edge(start.x, start.y, end.x, end.y, 1);
+    }
+
+    // 添加一条亚像素坐标的边，坐标需在 ±max_subpixel_coordinate 像素以内
+    void add_subpixel_edge(int64_t x0, int64_t y0, int64_t x1, int64_t y1) {
+        add_scaled_edge(x0, y0, x1, y1, subpixel_scale);
+    }
+
+    // 添加一个闭合的轮廓
+    template <typename Points>
+    void add_contour(const Points &points) {
+        for (size_t i = 0; i < points.size(); i++) {
+            add_edge(points[i], points[(i + 1) % points.size()]);
+        }
+    }
+
+    // 按填充规则求出 clip 内的每段内部像素，对每段调用 span(y, x0, x1)，x1 不包含在内
+    // 同一行的多段按 x 从小到大给出
+    template <typename SpanFunction>
+    void rasterize(const Bounds &clip, FillRule rule, SpanFunction &&span) {
+        // 1. 把边裁剪到 clip 的行范围内，并把交点推进到第一行
+        if (!clip_edges(clip)) {
+            return;
+        }
+        // 2. 按起始行排序，代替按行分桶的边表
+        std::sort(edges_.begin(), edges_.end(),
+            [](const Edge &lhs, const Edge &rhs) { return lhs.y_begin < rhs.y_begin; });
+
+        // 3. 活性边表，保存边的指针，按当前行的交点有序
+        std::pmr::vector<Edge *> active(edges_.get_allocator());
+        active.reserve(edges_.size());
+        size_t next = 0;
+        int64_t y = edges_.front().y_begin;
+        while (next < edges_.size() || !active.empty()) {
+            // 活性边表为空时直接跳到下一条边的起始行
+            if (active.empty()) {
+                y = edges_[next].y_begin;
+            }
+            // 3.1 插入从本行开始的边，从后往前找到插入位置
+            for (; next < edges_.size() && edges_[next].y_begin == y; next++) {
+                active.push_back(&edges_[next]);
+                for (size_t i = active.size() - 1; i > 0 && less(*active[i], *active[i - 1]); i--) {
+                    std::swap(active[i], active[i - 1]);
+                }
+            }
+            // 3.2 填充
+            emit_spans(active, static_cast<int>(y), clip, rule, span);
+            // 3.3 移除到本行结束的边，其余的边推进到下一行
+            y++;
+            std::erase_if(active, [y](const Edge *edge) { return edge->y_end <= y; });
+            for (auto *edge : active) {
+                advance(*edge);
+            }
+            // 3.4 只有相交的边会交换顺序，插入排序接近线性
+            for (size_t i = 1; i < active.size(); i++) {
+                for (size_t j = i; j > 0 && less(*active[j], *active[j - 1]); j--) {
+                    std::swap(active[j], active[j - 1]);
+                }
+            }
+        }
+    }
+
+    // 凸多边形的快速路径，结果与 rasterize 相同
+    // 凸多边形的非水平边分为向下和向上两条链，每条链上的边首尾相接地覆盖多边形的所有行，
+    // 每行恰好有两个交点，不需要维护活性边表
+    template <typename SpanFunction>
+    void rasterize_convex(const Bounds &clip, SpanFunction &&span) {
+        if (!clip_edges(clip)) {
+            return;
+        }
+        const auto middle = std::partition(
+            edges_.begin(), edges_.end(), [](const Edge &edge) { return edge.winding > 0; });
+        const auto by_row = [](const Edge &lhs, const Edge &rhs) {
+            return lhs.y_begin < rhs.y_begin;
+        };
+        std::sort(edges_.begin(), middle, by_row);
+        std::sort(middle, edges_.end(), by_row);
+        auto down = edges_.begin();
+        auto up = middle;
+        if (down == middle || up == edges_.end() || down->y_begin != up->y_begin) {
+            return;
+        }
+        for (int64_t y = down->y_begin;;) {
+            const bool ordered = !less(*up, *down);
+            const auto &left = ordered ? *down : *up;
+            const auto &right = ordered ? *up : *down;
+            const int64_t x0 = std::max<int64_t>(ceil_x(left), clip.min_x);
+            const int64_t x1 = std::min<int64_t>(ceil_x(right), clip.max_x);
+            if (x0 < x1) {
+                span(static_cast<int>(y), static_cast<int>(x0), static_cast<int>(x1));
+            }
+            // 到达边的末尾时换到链上的下一条边，下一条边从这一行开始
+            y++;
+            for (auto *chain : {&down, &up}) {
+                auto &edge = *chain;
+                if (edge->y_end > y) {
+                    advance(*edge);
+                    continue;
+                }
+                ++edge;
+                const auto end = chain == &down ? middle : edges_.end();
+                if (edge == end || edge->y_begin != y) {
+                    return;
+                }
+            }
+        }
+    }
+
+   private:
+    // 坐标以 1 / scale 像素为单位，像素中心为整数坐标，边覆盖满足 y0 <= y * scale < y1 的行
+    void add_scaled_edge(int64_t x0, int64_t y0, int64_t x1, int64_t y1, int64_t scale) {
+        if (y0 == y1) {
+            return;
+        }
+        const bool down = y0 < y1;
+        if (!down) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        Edge edge{};
+        edge.y_begin = ceil_div(y0, scale);
+        edge.y_end = ceil_div(y1, scale);
+        if (edge.y_begin >= edge.y_end) {
+            return;
+        }
+        // 第一行的交点 (x0 * dy + (y_begin * scale - y0) * dx) / (dy * scale)
+        const int64_t dx = x1 - x0;
+        const int64_t dy = y1 - y0;
+        edge.denominator = dy * scale;
+        const int64_t numerator = x0 * dy + (edge.y_begin * scale - y0) * dx;
+        edge.x = floor_div(numerator, edge.denominator);
+        edge.remainder = numerator - edge.x * edge.denominator;
+        // 每行的增量 dx / dy，通分到同一个分母
+        edge.step = floor_div(dx * scale, edge.denominator);
+        edge.step_remainder = dx * scale - edge.step * edge.denominator;
+        edge.winding = down ? 1 : -1;
+        edges_.push_back(edge);
+    }
+
+    // 把边裁剪到 clip 的行范围内，并把交点推进到第一行，返回是否还有边
+    bool clip_edges(const Bounds &clip) {
+        auto last = std::remove_if(edges_.begin(), edges_.end(), [&clip](Edge &edge) {
+            const int64_t y_begin = std::max<int64_t>(edge.y_begin, clip.min_y);
+            edge.y_end = std::min<int64_t>(edge.y_end, clip.max_y);
+            if (y_begin >= edge.y_end) {
+                return true;
+            }
+            // 跳过的行数不超过边的高度，乘积不会溢出
+            const auto skipped = static_cast<uint64_t>(y_begin - edge.y_begin);
+            const auto denominator = static_cast<uint64_t>(edge.denominator);
+            const auto fraction = skipped * static_cast<uint64_t>(edge.step_remainder) +
+                                  static_cast<uint64_t>(edge.remainder);
+            edge.x += static_cast<int64_t>(skipped) * edge.step +
+                      static_cast<int64_t>(fraction / denominator);
+            edge.remainder = static_cast<int64_t>(fraction % denominator);
+            edge.y_begin = y_begin;
+            return false;
+        });
+        edges_.erase(last, edges_.end());
+        return !edges_.empty();
+    }
+
+    // 交点推进到下一行
+    static void advance(Edge &edge) {
+        edge.x += edge.step;
+        edge.remainder += edge.step_remainder;
+        if (edge.remainder >= edge.denominator) {
+            edge.x++;
+            edge.remainder -= edge.denominator;
+        }
+    }
+
+    static int64_t floor_div(int64_t a, int64_t b) {
+        const int64_t q = a / b;
+        return q * b > a ? q - 1 : q;
+    }
+
+    static int64_t ceil_div(int64_t a, int64_t b) { return -floor_div(-a, b); }
+
+    static bool less(const Edge &lhs, const Edge &rhs) {
+        if (lhs.x != rhs.x) {
+            return lhs.x < rhs.x;
+        }
+        // 比较小数部分 lhs.remainder / lhs.denominator < rhs.remainder / rhs.denominator
+        // 分母都小于 2^32 时两个乘积都小于 2^64，精确比较
+        if (lhs.denominator <= UINT32_MAX && rhs.denominator <= UINT32_MAX) {
+            return static_cast<uint64_t>(lhs.remainder) * static_cast<uint64_t>(rhs.denominator) <
+                   static_cast<uint64_t>(rhs.remainder) * static_cast<uint64_t>(lhs.denominator);
+        }
+        // 亚像素的边分母更大，用浮点数比较。只有两个交点落在同一对相邻像素之间且都不是整数时，
+        // 浮点误差才可能颠倒顺序，这时两个交点之间没有像素，填充结果不变
+        return static_cast<double>(lhs.remainder) * static_cast<double>(rhs.denominator) <
+               static_cast<double>(rhs.remainder) * static_cast<double>(lhs.denominator);
+    }
+
+    // 交点右侧（含交点）第一个像素
+    static int64_t ceil_x(const Edge &edge) { return edge.x + (edge.remainder > 0 ? 1 : 0); }
+
+    template <typename SpanFunction>
+    void emit_spans(const std::pmr::vector<Edge *> &active, int y, const Bounds &clip,
+        FillRule rule, SpanFunction &span) const {
+        const auto emit = [&](const Edge &left, const Edge &right) {
+            const int64_t x0 = std::max<int64_t>(ceil_x(left), clip.min_x);
+            const int64_t x1 = std::min<int64_t>(ceil_x(right), clip.max_x);
+            if (x0 < x1) {
+                span(y, static_cast<int>(x0), static_cast<int>(x1));
+            }
+        };
+        if (rule == FillRule::EVEN_ODD) {
+            // 奇偶规则：交点两两配对
+            for (size_t i = 0; i + 1 < active.size(); i += 2) {
+                emit(*active[i], *active[i + 1]);
+            }
+            return;
+        }
+        // 非零环绕规则：环绕数从 0 变为非 0 时进入内部，回到 0 时离开
+        int winding = 0;
+        const Edge *enter = nullptr;
+        for (const auto *edge : active) {
+            if (winding == 0) {
+                enter = edge;
+            }
+            winding += edge->winding;
+            if (winding == 0) {
+                emit(*enter, *edge);
+            }
+        }
+    }
+};
+
+#endif  //RENDERENGINE_SCANLINE_HPP
@@ -0,0 +1,313 @@
+#ifndef RENDERENGINE_STROKE_HPP
+#define RENDERENGINE_STROKE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory_resource>
+#include <numbers>
+#include <vector>
+
+#include "options.hpp"
+#include "scanline.hpp"
+#include "vector.hpp"
+
+namespace RenderCore {
+class Stroker;
+}
+
+// 宽线描边
+// 把折线按线宽、线型、端点和拐角样式展开成多个闭合轮廓：每条线段一个矩形，每个拐角一个三角形、
+// 四边形或圆，每个端点一个矩形或圆。所有轮廓统一为同一方向，按非零环绕规则一起填充，
+// 轮廓之间重叠的部分只绘制一次，半透明时不会重复混合，工作量与描边的面积成正比
+// 像素中心在轮廓内时绘制，宽为 w 的水平、竖直线段正好覆盖 w 行或 w 列
+class RenderCore::Stroker {
+   public:
+    using LineCap = PenOptions::LineCap;
+    using LineJoin = PenOptions::LineJoin;
+
+    // 尖角拐角的长度与半线宽之比的上限，超过时改为斜角
+    static constexpr double miter_limit = 4.0;
+    // 圆形端点、拐角和圆弧折线化时与真实边界的最大偏差（像素）
+    static constexpr double tolerance = 0.25;
+    // 线宽上限，加上尖角的长度后坐标仍在扫描线的亚像素坐标范围内
+    static constexpr int max_width = 1 << 20;
+
+   private:
+    const PenOptions &options_;
+    ScanlineRasterizer &rasterizer_;
+    double half_width_;
+    // 去掉重复点后的折线
+    std::pmr::vector<Vector2d> path_;
+    // 虚线中的一段
+    std::pmr::vector<Vector2d> dash_;
+    // 正在生成的轮廓
+    std::pmr::vector<Vector2d> contour_;
+
+   public:
+    Stroker(const PenOptions &options, ScanlineRasterizer &rasterizer,
+        std::pmr::memory_resource *resource)
+        : options_(options),
+          rasterizer_(rasterizer),
+          half_width_(std::clamp(options.width, 1, max_width) / 2.0),
+          path_(resource),
+          dash_(resource),
+          contour_(resource) {}
+
+    // 描边超出折线顶点的最大距离（像素）
+    static double extent(const PenOptions &options) {
+        const double half = std::clamp(options.width, 1, max_width) / 2.0;
+        double scale = 1.0;
+        if (options.cap == LineCap::SQUARE) {
+            scale = std::numbers::sqrt2;
+        }
+        if (options.join == LineJoin::MITER) {
+            scale = std::max(scale, miter_limit);
+        }
+        return half * scale;
+    }
+
+    // 把椭圆弧 [start, end]（极角，弧度）折线化后追加到 points，与真实曲线的偏差不超过 tolerance
+    template <typename Points>
+    static void flatten_arc(const Vector2d &center, double radius_x, double radius_y, double start,
+        double end, Points &points) {
+        const int segments = arc_segment_count(std::max(radius_x, radius_y), end - start);
+        for (int i = 0; i <= segments; i++) {
+            const double angle = start + (end - start) * i / segments;
+            points.push_back(
+                {center.x + radius_x * std::cos(angle), center.y + radius_y * std::sin(angle)});
+        }
+    }
+
+    // 半径为 radius、圆心角为 angle 的圆弧折线化时的段数
+    static int arc_segment_count(double radius, double angle) {
+        if (!(radius > tolerance) || !(angle > 0)) {
+            return 1;
+        }
+        // 半径为 r、圆心角为 θ 的弦与圆弧的最大距离为 r(1 - cos(θ / 2))
+        const double step = 2 * std::acos(1 - tolerance / radius);
+        return static_cast<int>(std::clamp(std::ceil(angle / step), 1.0, 65536.0));
+    }
+
+    // 描边一条折线，closed 为 true 时首尾相连
+    template <typename Points>
+    void stroke(const Points &points, bool closed) {
+        path_.clear();
+        for (const auto &point : points) {
+            const auto v = clamp_point(static_cast<double>(point.x), static_cast<double>(point.y));
+            if (path_.empty() || !same_point(v, path_.back())) {
+                path_.push_back(v);
+            }
+        }
+        if (path_.size() > 1 && same_point(path_.front(), path_.back())) {
+            path_.pop_back();
+            closed = true;
+        }
+        // 只有两个点的闭合折线是来回的线段，按不闭合处理
+        closed = closed && path_.size() > 2;
+        if (path_.empty()) {
+            return;
+        }
+        if (options_.type == PenOptions::LineType::SOLID) {
+            stroke_path(path_, closed);
+        } else {
+            stroke_dashes(closed);
+        }
+    }
+
+   private:
+    static bool same_point(const Vector2d &lhs, const Vector2d &rhs) {
+        return lhs.x == rhs.x && lhs.y == rhs.y;
+    }
+
+    // 限制坐标范围，保证亚像素坐标不会溢出，只影响远在画布外的部分
+    static Vector2d clamp_point(double x, double y) {
+        const double limit = static_cast<double>(ScanlineRasterizer::max_subpixel_coordinate) / 2;
+        return {std::clamp(x, -limit, limit), std::clamp(y, -limit, limit)};
+    }
+
+    // 虚线：线型模式的每一位对应折线上 dash 个像素的长度，连续为 1 的位合成一段描边
+    // 长度按切比雪夫距离计算，与线宽为 1 时逐像素计数的下标一致；闭合折线的虚线绕过起点连续计数
+    void stroke_dashes(bool closed) {
+        if (closed) {
+            path_.push_back(path_.front());
+        }
+        if (path_.size() == 1) {
+            if (line_type_pattern(options_.type) & 1) {
+                add_dot(path_[0]);
+            }
+            return;
+        }
+        double total = 0;
+        for (size_t i = 0; i + 1 < path_.size(); i++) {
+            total += segment_length(i);
+        }
+        const auto pattern = line_type_pattern(options_.type);
+        const double dash = std::max(options_.dash, 1);
+        const auto on = [pattern](int64_t unit) { return (pattern >> (unit % 16)) & 1; };
+        // 沿折线推进的位置：当前线段和线段起点的长度
+        size_t segment = 0;
+        double segment_start = 0;
+        const auto point_at = [&](double length) {
+            while (segment + 2 < path_.size() && segment_start + segment_length(segment) < length) {
+                segment_start += segment_length(segment);
+                segment++;
+            }
+            const double t = (length - segment_start) / segment_length(segment);
+            return path_[segment] + (path_[segment + 1] - path_[segment]) * std::clamp(t, 0.0, 1.0);
+        };
+        for (int64_t unit = 0; static_cast<double>(unit) * dash <= total;) {
+            if (!on(unit)) {
+                unit++;
+                continue;
+            }
+            int64_t last = unit;
+            while (static_cast<double>(last + 1) * dash <= total && on(last + 1)) {
+                last++;
+            }
+            // 第 unit 到第 last 个单位绘制，覆盖长度 [unit * dash, (last + 1) * dash - 1]
+            const double begin = static_cast<double>(unit) * dash;
+            const double end = std::min(static_cast<double>(last + 1) * dash - 1, total);
+            dash_.clear();
+            dash_.push_back(point_at(begin));
+            while (segment + 2 < path_.size() && segment_start + segment_length(segment) < end) {
+                segment_start += segment_length(segment);
+                segment++;
+                if (!same_point(path_[segment], dash_.back())) {
+                    dash_.push_back(path_[segment]);
+                }
+            }
+            const auto tail = point_at(end);
+            if (!same_point(tail, dash_.back())) {
+                dash_.push_back(tail);
+            }
+            if (dash_.size() == 1) {
+                add_dot(dash_[0]);
+            } else {
+                stroke_path(dash_, false);
+            }
+            unit = last + 1;
+        }
+    }
+
+    [[nodiscard]] double segment_length(size_t i) const {
+        const auto d = path_[i + 1] - path_[i];
+        return std::max(std::abs(d.x), std::abs(d.y));
+    }
+
+    // 描边没有重复点的折线
+    void stroke_path(const std::pmr::vector<Vector2d> &path, bool closed) {
+        const size_t n = path.size();
+        if (n == 1) {
+            add_dot(path[0]);
+            return;
+        }
+        const double h = half_width_;
+        const size_t segments = closed ? n : n - 1;
+        const auto direction = [&path, n](size_t i) {
+            return vector_normalize(path[(i + 1) % n] - path[i]);
+        };
+        for (size_t i = 0; i < segments; i++) {
+            auto a = path[i];
+            auto b = path[(i + 1) % n];
+            const auto d = direction(i);
+            // 方头端点把线段向外延伸半个线宽
+            if (!closed && options_.cap == LineCap::SQUARE) {
+                if (i == 0) {
+                    a -= d * h;
+                }
+                if (i + 1 == segments) {
+                    b += d * h;
+                }
+            }
+            const Vector2d normal{-d.y * h, d.x * h};
+            contour_.assign({a + normal, b + normal, b - normal, a - normal});
+            add_contour();
+        }
+        for (size_t i = closed ? 0 : 1; i < (closed ? n : n - 1); i++) {
+            add_join(path[i], direction((i + n - 1) % n), direction(i));
+        }
+        if (!closed && options_.cap == LineCap::ROUND) {
+            add_disc(path[0]);
+            add_disc(path[n - 1]);
+        }
+    }
+
+    // 拐角：补上两条线段外侧之间的缺口
+    void add_join(const Vector2d &vertex, const Vector2d &d0, const Vector2d &d1) {
+        const double cross = d0.x * d1.y - d0.y * d1.x;
+        const double dot = d0.x * d1.x + d0.y * d1.y;
+        if (cross == 0 && dot > 0) {
+            return;
+        }
+        if (options_.join == LineJoin::ROUND) {
+            add_disc(vertex);
+            return;
+        }
+        // 向法线一侧转弯时，缺口在另一侧
+        const double side = cross > 0 ? -half_width_ : half_width_;
+        const Vector2d n0{-d0.y, d0.x};
+        const Vector2d n1{-d1.y, d1.x};
+        const auto p0 = vertex + n0 * side;
+        const auto p1 = vertex + n1 * side;
+        const auto bisector = n0 + n1;
+        const double length = vector_length(bisector);
+        // 尖角顶点到拐点的距离为 h / cos(φ / 2) = 2h / |n0 + n1|，φ 为转角
+        if (options_.join == LineJoin::MITER && length * miter_limit >= 2) {
+            const auto miter = vertex + bisector * (2 * side / (length * length));
+            contour_.assign({vertex, p0, miter, p1});
+        } else {
+            contour_.assign({vertex, p0, p1});
+        }
+        add_contour();
+    }
+
+    // 孤立的点：方头为正方形，圆头为圆，平头不绘制
+    void add_dot(const Vector2d &point) {
+        const double h = half_width_;
+        if (options_.cap == LineCap::SQUARE) {
+            contour_.assign({{point.x - h, point.y - h}, {point.x + h, point.y - h},
+                {point.x + h, point.y + h}, {point.x - h, point.y + h}});
+            add_contour();
+        } else if (options_.cap == LineCap::ROUND) {
+            add_disc(point);
+        }
+    }
+
+    void add_disc(const Vector2d &center) {
+        contour_.clear();
+        const auto segments = std::max(arc_segment_count(half_width_, 2 * std::numbers::pi), 8);
+        for (int i = 0; i < segments; i++) {
+            const double angle = 2 * std::numbers::pi * i / segments;
+            contour_.push_back({center.x + half_width_ * std::cos(angle),
+                center.y + half_width_ * std::sin(angle)});
+        }
+        add_contour();
+    }
+
+    // 把轮廓统一为正方向后加入扫描线，面积为 0 的轮廓不影响结果，直接跳过
+    void add_contour() {
+        double area = 0;
+        for (size_t i = 0; i < contour_.size(); i++) {
+            const auto &p = contour_[i];
+            const auto &q = contour_[(i + 1) % contour_.size()];
+            area += p.x * q.y - q.x * p.y;
+        }
+        if (!(std::abs(area) > 0)) {
+            return;
+        }
+        if (area < 0) {
+            std::reverse(contour_.begin(), contour_.end());
+        }
+        const auto scale = static_cast<double>(ScanlineRasterizer::subpixel_scale);
+        const auto subpixel = [scale](double v) { return std::llround(v * scale); };
+        for (size_t i = 0; i < contour_.size(); i++) {
+            const auto &p = contour_[i];
+            const auto &q = contour_[(i + 1) % contour_.size()];
+            rasterizer_.add_subpixel_edge(
+                subpixel(p.x), subpixel(p.y), subpixel(q.x), subpixel(q.y));
+        }
+    }
+};
+
+#endif  //RENDERENGINE_STROKE_HPP
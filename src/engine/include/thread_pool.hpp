@@ -0,0 +1,121 @@
+#ifndef RENDERENGINE_THREAD_POOL_HPP
+#define RENDERENGINE_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RenderCore {
+class ThreadPool;
+}
+
+// 线程池
+// 只支持 parallel_for：把 [0, count) 的任务分给所有线程执行，调用线程也参与执行
+// 任务通过原子计数器领取，先完成的线程会继续领取剩余任务
+class RenderCore::ThreadPool {
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+
+    // 当前批次的任务
+    const std::function<void(size_t, size_t)> *task_{nullptr};
+    size_t task_count_{0};
+    std::atomic<size_t> next_task_{0};
+
+    // 每次 parallel_for 递增，用于唤醒工作线程
+    uint64_t generation_{0};
+    // 尚未完成当前批次的工作线程数
+    size_t busy_workers_{0};
+    bool stop_{false};
+
+    // 领取并执行任务，直到任务全部被领取
+    void run_tasks(size_t thread_index) {
+        for (size_t i = next_task_.fetch_add(1); i < task_count_; i = next_task_.fetch_add(1)) {
+            (*task_)(i, thread_index);
+        }
+    }
+
+    void worker_loop(size_t thread_index) {
+        uint64_t generation = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_cv_.wait(lock, [&] { return stop_ || generation_ != generation; });
+                if (stop_) {
+                    return;
+                }
+                generation = generation_;
+            }
+            run_tasks(thread_index);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--busy_workers_ == 0) {
+                    done_cv_.notify_one();
+                }
+            }
+        }
+    }
+
+   public:
+    // threads: 总线程数（包含调用线程），小于等于 1 时不创建工作线程
+    explicit ThreadPool(size_t threads) {
+        for (size_t i = 1; i < threads; i++) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    // 总线程数（包含调用线程）
+    [[nodiscard]] size_t size() const { return workers_.size() + 1; }
+
+    // 并行执行 task(index, thread_index)，index 属于 [0, count)
+    // thread_index 属于 [0, size())，调用线程为 0，可用于索引线程私有的数据
+    // 返回时所有任务均已完成
+    void parallel_for(size_t count, const std::function<void(size_t, size_t)> &task) {
+        if (count == 0) {
+            return;
+        }
+        if (workers_.empty() || count == 1) {
+            for (size_t i = 0; i < count; i++) {
+                task(i, 0);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            task_count_ = count;
+            next_task_.store(0);
+            busy_workers_ = workers_.size();
+            generation_++;
+        }
+        start_cv_.notify_all();
+        run_tasks(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+        task_ = nullptr;
+    }
+};
+
+#endif  //RENDERENGINE_THREAD_POOL_HPP
@@ -118,6 +118,16 @@ struct TransformMatrixApply<BezierCurve> : std::true_type {
     }
 };
 
+template <>
+struct TransformMatrixApply<BsplineCurve> : std::true_type {
+    // 仿射变换后的 B 样条曲线就是控制点变换后的曲线，节点向量不变
+    void operator()(BsplineCurve &curve, const Matrix3f &transform) const {
+        for (auto &point : curve.control_points) {
+            apply_transform_matrix(point, transform);
+        }
+    }
+};
+
 }  // namespace RenderCore
 
 #endif  //RENDERENGINE_TRANSFORM_HPP
@@ -1,23 +1,37 @@
 //
 // Created by Autumn Sound on 2024/9/5.
 //
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory_resource>
 #include <numbers>
 #include <ostream>
 #include <random>
+#include <set>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 #include "color.hpp"
 #include "engine.hpp"
+#include "frame_encoder.hpp"
+#include "image_encoder.hpp"
 #include "line.hpp"
 #include "matrix.hpp"
 #include "point.hpp"
 #include "polygon.hpp"
 #include "rectangle.hpp"
+#include "scanline.hpp"
 #include "transform.hpp"
 #include "vector.hpp"
 
@@ -37,6 +51,28 @@ void ex_3();
 void ex_4();
 
 void perf_test();
+void parallel_test();
+void incremental_test();
+void blend_test();
+void frame_test();
+
+void delta_test();
+
+void image_test();
+
+void edit_test();
+
+void geometry_cache_test();
+
+void ellipse_test();
+
+void fill_rule_test();
+
+void convex_polygon_test();
+
+void fill_connectivity_test();
+void stroke_test();
+void geometry_transform_test();
 
 void render_and_save(const std::string &filename) {
     // 计时
@@ -71,6 +107,20 @@ int main() {
     TEST(ex_4);
 
     TEST(perf_test);
+    TEST(parallel_test);
+    TEST(incremental_test);
+    TEST(blend_test);
+    TEST(frame_test);
+    TEST(delta_test);
+    TEST(image_test);
+    TEST(edit_test);
+    TEST(geometry_cache_test);
+    TEST(ellipse_test);
+    TEST(fill_rule_test);
+    TEST(convex_polygon_test);
+    TEST(fill_connectivity_test);
+    TEST(stroke_test);
+    TEST(geometry_transform_test);
 
     render_and_save("output.bmp");
 #ifdef _WIN32
@@ -392,3 +442,682 @@ void perf_test() {
         engine.add_primitive(random_primitive());
     }
 }
+
+void parallel_test() {
+    perf_test();
+
+    // 分块并行渲染的结果应与串行渲染逐像素一致
+    const int threads = static_cast<int>(std::max(4u, std::thread::hardware_concurrency()));
+    RenderEngine parallel_engine(WIDTH, HEIGHT, threads);
+    for (const auto &primitive : *engine.get_primitives()) {
+        parallel_engine.add_primitive(primitive);
+    }
+    engine.render();
+    auto start = std::chrono::high_resolution_clock::now();
+    parallel_engine.render();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    std::cout << "Parallel elapsed time (" << threads << " threads): " << elapsed.count() << " s"
+              << std::endl;
+    const bool identical = engine.get_frame_buffer() == parallel_engine.get_frame_buffer();
+    std::cout << "Parallel output " << (identical ? "matches" : "differs from") << " serial output"
+              << std::endl;
+    assert(identical);
+
+    // 各分块只遍历图元落在分块内的部分，并行渲染不应慢于串行渲染
+    // 取多次整帧重绘的最短耗时，减少调度抖动的影响
+    auto full_render_time = [](RenderEngine &target) {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < 3; i++) {
+            target.init();
+            auto begin = std::chrono::high_resolution_clock::now();
+            target.render();
+            std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - begin;
+            best = std::min(best, time.count());
+        }
+        return best;
+    };
+    const double serial_time = full_render_time(engine);
+    const double parallel_time = full_render_time(parallel_engine);
+    std::cout << "Full redraw: serial " << serial_time << " s, parallel " << parallel_time << " s"
+              << std::endl;
+    if (std::thread::hardware_concurrency() > 1) {
+        assert(parallel_time <= serial_time);
+    } else {
+        // 单核时线程只能轮流执行，分块带来的额外工作应当有限
+        assert(parallel_time <= serial_time * 2);
+    }
+}
+
+void incremental_test() {
+    perf_test();
+    engine.render();
+
+    // 追加、修改、插入、删除图元后增量渲染，结果应与重新渲染整帧一致
+    auto start = std::chrono::high_resolution_clock::now();
+    engine.add_primitive(make_line({100, 100}, {200, 150}));
+    engine.render();
+    engine.modify_primitive(1, make_rectangle({300, 300}, {320, 330}));
+    engine.insert_primitive(make_circle_center_radius({500, 400}, 10), 3);
+    engine.remove_primitive(5);
+    engine.render();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    std::cout << "Incremental elapsed time: " << elapsed.count() << " s" << std::endl;
+
+    RenderEngine full_engine(WIDTH, HEIGHT);
+    for (const auto &primitive : *engine.get_primitives()) {
+        full_engine.add_primitive(primitive);
+    }
+    full_engine.render();
+    const bool identical = engine.get_frame_buffer() == full_engine.get_frame_buffer();
+    std::cout << "Incremental output " << (identical ? "matches" : "differs from")
+              << " full redraw output" << std::endl;
+    assert(identical);
+}
+
+void blend_test() {
+    // 半透明矩形，分别使用浮点混合和定点混合
+    const auto draw = [](RenderEngine &target) {
+        for (int i = 0; i < 20; i++) {
+            target.set_pen_options({.color = {1, 1, 1, 0.3},
+                .fill_color = {i / 20.0f, 0.5f, 1 - i / 20.0f, 0.25f + i / 40.0f}});
+            target.add_primitive(make_rectangle({i * 30, i * 20}, {i * 30 + 300, i * 20 + 200}));
+        }
+    };
+    draw(engine);
+
+    RenderEngine fixed_engine(WIDTH, HEIGHT);
+    GlobalOptions options;
+    options.blend_mode = BlendMode::FIXED;
+    fixed_engine.set_global_options(options);
+    draw(fixed_engine);
+    engine.render();
+    auto start = std::chrono::high_resolution_clock::now();
+    fixed_engine.render();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    std::cout << "Fixed-point elapsed time: " << elapsed.count() << " s" << std::endl;
+
+    // 定点混合与浮点混合相差不超过 1
+    const auto float_buffer = engine.get_frame_buffer();
+    const auto fixed_buffer = fixed_engine.get_frame_buffer();
+    int max_diff = 0;
+    for (size_t i = 0; i < float_buffer.size(); i++) {
+        max_diff = std::max(max_diff, std::abs(float_buffer[i] - fixed_buffer[i]));
+    }
+    std::cout << "Blend kernel: " << static_cast<int>(blend_kernel())
+              << ", fixed-point max difference: " << max_diff << std::endl;
+    assert(max_diff <= 1);
+}
+
+void frame_test() {
+    lab_1();
+    engine.render();
+
+    // 持有快照时渲染，快照内容不变，新帧写入其他缓冲区
+    const auto frame = engine.get_frame();
+    const RenderEngine::Buffer snapshot(frame->data(), frame->data() + frame->size());
+    engine.add_primitive(make_line({0, 0}, {WIDTH - 1, HEIGHT - 1}));
+    engine.render();
+    const bool unchanged =
+        RenderEngine::Buffer(frame->data(), frame->data() + frame->size()) == snapshot;
+    const bool swapped = engine.get_frame() != frame;
+    std::cout << "Snapshot " << (unchanged ? "unchanged" : "modified") << ", frame buffer "
+              << (swapped ? "swapped" : "reused") << std::endl;
+    assert(unchanged && swapped);
+
+    // 快照释放后，缓冲区循环使用，不再分配
+    std::set<const Bitmap *> buffers;
+    for (int i = 0; i < 10; i++) {
+        const auto held = engine.get_frame();
+        engine.add_primitive(make_line({i * 10, 0}, {i * 10, HEIGHT - 1}));
+        engine.render();
+        buffers.insert(engine.get_frame().get());
+    }
+    std::cout << "Frame buffers used: " << buffers.size() << std::endl;
+    assert(buffers.size() <= 3);
+}
+
+void delta_test() {
+    lab_1();
+    engine.render();
+    const auto base = engine.get_frame();
+    const auto base_version = engine.get_frame_version();
+
+    // 客户端收到关键帧
+    Bitmap client(WIDTH, HEIGHT);
+    FrameEncoder encoder;
+    DecodedFrame decoded;
+    const auto &key = encoder.encode_key(*base, base_version);
+    const auto key_size = key.size();
+    [[maybe_unused]] bool ok = decode_frame(client, key.data(), key.size(), decoded);
+    assert(ok && decoded.type == FrameType::KEY);
+
+    // 小范围修改后只发送改变的分块
+    engine.set_pen_options({.color = Colors::Red, .width = 3});
+    engine.add_primitive(make_line({100, 100}, {200, 150}));
+    engine.render();
+    const auto frame = engine.get_frame();
+    const auto &delta =
+        encoder.encode_delta(*base, base_version, *frame, engine.get_frame_version());
+    const auto delta_size = delta.size();
+    ok = decode_frame(client, delta.data(), delta.size(), decoded);
+    assert(ok && decoded.type == FrameType::DELTA && decoded.base_version == base_version);
+    const bool same = std::memcmp(client.data(), frame->data(), frame->size()) == 0;
+    std::cout << "Key frame: " << key_size << " bytes, delta frame: " << delta_size << " bytes, "
+              << decoded.tile_count << " tiles, " << (same ? "match" : "differ") << std::endl;
+    assert(same && delta_size < key_size / 10);
+}
+
+void image_test() {
+    lab_1();
+    engine.render();
+    const auto frame = engine.get_frame();
+
+    // BMP 编码与逐像素写文件的结果一致
+    frame->save_bmp("image_test_reference.bmp");
+    std::ifstream file("image_test_reference.bmp", std::ios::binary);
+    const ImageEncoder::Buffer reference{
+        std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    ImageEncoder encoder;
+    const bool same = encoder.encode_bmp(*frame) == reference;
+
+    const auto qoi_size = encoder.encode_qoi(*frame).size();
+    const auto png_size = encoder.encode_png(*frame).size();
+    // 取出的缓冲区交还后，下一次编码复用它的内存
+    auto taken = encoder.take_buffer();
+    const auto *storage = taken.data();
+    encoder.reuse_buffer(std::move(taken));
+    const bool reused = encoder.encode_png(*frame).data() == storage;
+    std::cout << "BMP " << (same ? "match" : "differ") << ", raw: " << frame->size()
+              << " bytes, QOI: " << qoi_size << " bytes, PNG: " << png_size << " bytes"
+              << std::endl;
+    std::cout << "Encoder buffer " << (reused ? "reused" : "reallocated") << std::endl;
+    assert(same && reused && qoi_size < frame->size() && png_size < frame->size());
+    engine.save("image_test.png");
+    engine.save("image_test.qoi");
+}
+
+void edit_test() {
+    lab_1();
+    engine.render();
+    const auto snapshot = engine.get_primitives();
+    const auto count = snapshot->size();
+
+    // 编辑与渲染并发进行，编辑不需要等待渲染完成
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 0; i < 1000; i++) {
+            engine.add_primitive(make_line({i % WIDTH, 0}, {WIDTH - 1 - i % WIDTH, HEIGHT - 1}));
+            if (i % 100 == 99) {
+                engine.modify_primitive(count, make_rectangle({i, i}, {i + 50, i + 30}));
+                engine.remove_primitive(count + 1);
+            }
+        }
+        done = true;
+    });
+    int renders = 0;
+    while (!done) {
+        engine.render();
+        renders++;
+    }
+    writer.join();
+    engine.render();
+
+    // 之前取得的快照不受之后编辑的影响
+    const bool unchanged = snapshot->size() == count;
+    RenderEngine full_engine(WIDTH, HEIGHT);
+    for (const auto &primitive : *engine.get_primitives()) {
+        full_engine.add_primitive(primitive);
+    }
+    full_engine.render();
+    const bool identical = engine.get_frame_buffer() == full_engine.get_frame_buffer();
+    std::cout << "Primitive snapshot " << (unchanged ? "unchanged" : "modified") << ", "
+              << renders << " renders during edits, output "
+              << (identical ? "matches" : "differs from") << " full redraw output" << std::endl;
+    assert(unchanged && identical);
+}
+
+void geometry_cache_test() {
+    perf_test();
+    auto options = engine.get_global_options();
+    options.clip = {true, make_rectangle({100, 100}, {700, 500})};
+    engine.set_global_options(options);
+    engine.render();
+
+    // 只修改背景色，重绘整帧时变换、裁剪和曲线采样的结果都从缓存中取得
+    options.background_color = Colors::White;
+    engine.set_global_options(options);
+    engine.render();
+
+    RenderEngine full_engine(WIDTH, HEIGHT);
+    full_engine.set_global_options(options);
+    for (const auto &primitive : *engine.get_primitives()) {
+        full_engine.add_primitive(primitive);
+    }
+    full_engine.render();
+    const bool identical = engine.get_frame_buffer() == full_engine.get_frame_buffer();
+    std::cout << "Cached geometry output " << (identical ? "matches" : "differs from")
+              << " full redraw output" << std::endl;
+    assert(identical);
+}
+
+void ellipse_test() {
+    // 半透明填充的椭圆和实心圆，填充与边线不重叠
+    engine.set_pen_options({.color = Colors::Red, .fill_color = {0, 0, 1, 0.5}});
+    engine.add_primitive(make_ellipse({400, 300}, 300, 120));
+    engine.set_pen_options({.color = Colors::Yellow, .fill_color = {0, 1, 0, 0.5}});
+    engine.add_primitive(make_ellipse({400, 300}, 100, 100));
+    // 跨越多个八分区间的圆弧
+    engine.set_pen_options({.color = Colors::Cyan, .width = 3});
+    engine.add_primitive(make_arc_center_radius_angle({400, 300}, 250, -2.5, 0.7));
+    engine.add_primitive(make_arc_three_points({150, 300}, {400, 550}, {650, 300}));
+
+    // 单独渲染一个图元，返回被绘制的像素
+    const auto rendered_pixels = [](const Primitive &primitive, const PenOptions &pen) {
+        RenderEngine local(WIDTH, HEIGHT);
+        local.set_pen_options(pen);
+        local.add_primitive(primitive);
+        local.render();
+        const auto frame = local.get_frame();
+        const auto background = frame->get_pixel(0, 0);
+        std::set<std::pair<int, int>> pixels;
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                if (frame->get_pixel(x, y) != background) {
+                    pixels.emplace(x, y);
+                }
+            }
+        }
+        return pixels;
+    };
+
+    // 圆弧上的点应恰好是整圆上极角 atan2(dy, dx) 落在 [start, end] 内的点
+    // 包括跨越多个八分区间、端点落在区间边界上、超出 [-π, π] 的圆弧
+    const PenOptions outline{.color = Colors::White, .fill_color = {0, 0, 0, 0}};
+    const Point center{300, 300};
+    const auto circle = rendered_pixels(make_circle_center_radius(center, 180), outline);
+    const std::pair<float, float> arcs[] = {{-2.5f, 0.7f}, {0.1f, 3.0f}, {-0.3f, 0.3f},
+        {-std::numbers::pi_v<float>, std::numbers::pi_v<float>},
+        {std::numbers::pi_v<float> / 4, std::numbers::pi_v<float> * 3 / 4}, {-4.0f, -1.0f},
+        {1.0f, 5.0f}, {-1.2f, -1.1f}};
+    bool arc_match = true;
+    for (const auto &[start, end] : arcs) {
+        const auto arc = rendered_pixels(
+            make_arc_center_radius_angle(center, 180, start, end), outline);
+        for (const auto &[x, y] : circle) {
+            const double angle = std::atan2(y - center.y, x - center.x);
+            // 与端点极角几乎相等的点受舍入影响，不作判断
+            if (std::abs(angle - start) < 1e-6 || std::abs(angle - end) < 1e-6) {
+                continue;
+            }
+            const bool inside = angle >= start && angle <= end;
+            arc_match = arc_match && inside == arc.contains({x, y});
+        }
+        for (const auto &pixel : arc) {
+            arc_match = arc_match && circle.contains(pixel);
+        }
+    }
+
+    // 椭圆的填充关于圆心对称，且每行的填充都在同一行的边线之间，不与边线重叠
+    bool symmetric = true;
+    bool inside_outline = true;
+    for (const auto &[rx, ry] : {std::pair{250, 90}, std::pair{60, 200}, std::pair{7, 3}}) {
+        const auto ellipse = make_ellipse(center, rx, ry);
+        const auto fill = rendered_pixels(
+            ellipse, {.color = {0, 0, 0, 0}, .fill_color = Colors::White});
+        const auto edge = rendered_pixels(ellipse, outline);
+        std::map<int, std::pair<int, int>> rows;
+        for (const auto &[x, y] : edge) {
+            auto [it, inserted] = rows.try_emplace(y, x, x);
+            it->second = {std::min(it->second.first, x), std::max(it->second.second, x)};
+        }
+        for (const auto &[x, y] : fill) {
+            symmetric = symmetric && fill.contains({2 * center.x - x, y}) &&
+                        fill.contains({x, 2 * center.y - y});
+            const auto row = rows.find(y);
+            inside_outline = inside_outline && !edge.contains({x, y}) && row != rows.end() &&
+                             row->second.first < x && x < row->second.second;
+        }
+    }
+    std::cout << "Arc pixels " << (arc_match ? "match" : "differ") << " atan2 reference, fill "
+              << (symmetric ? "symmetric" : "asymmetric") << ", fill "
+              << (inside_outline ? "inside" : "outside") << " outline" << std::endl;
+    assert(arc_match && symmetric && inside_outline);
+}
+
+void fill_rule_test() {
+    // 自相交的五角星：奇偶规则中间是空的，非零环绕规则中间被填满
+    const auto star = [](int dx) {
+        return make_polygon(
+            {{200 + dx, 100}, {290 + dx, 380}, {50 + dx, 210}, {350 + dx, 210}, {110 + dx, 380}});
+    };
+    engine.set_pen_options({.color = Colors::White, .fill_color = {1, 0, 0, 0.5}});
+    engine.add_primitive(star(0));
+    engine.set_pen_options({.color = Colors::White,
+        .fill_color = {0, 0, 1, 0.5},
+        .fill_rule = PenOptions::FillRule::NON_ZERO});
+    engine.add_primitive(star(400));
+    // 部分位于画面上方的多边形，只扫描画面内的行
+    engine.set_pen_options({.color = Colors::Yellow, .fill_color = Colors::Green});
+    engine.add_primitive(make_polygon({{100, -300}, {700, -200}, {400, 80}}));
+    // 共用一条斜边的两个半透明多边形，公共边上的像素只属于其中一个
+    engine.set_pen_options({.color = {0, 0, 0, 0}, .fill_color = {1, 1, 0, 0.5}});
+    engine.add_primitive(make_polygon({{100, 450}, {250, 450}, {150, 550}, {100, 550}}));
+    engine.add_primitive(make_polygon({{250, 450}, {300, 450}, {300, 550}, {150, 550}}));
+    engine.render();
+
+    const auto frame = engine.get_frame();
+    const auto background = frame->get_pixel(0, HEIGHT - 1);
+    // 五角星的尖角只被覆盖一次，两种规则都填充；中心被覆盖两次，只有非零环绕规则填充
+    const bool even_odd = frame->get_pixel(200, 150) != background &&
+                          frame->get_pixel(200, 260) == background;
+    const bool non_zero = frame->get_pixel(600, 150) != background &&
+                          frame->get_pixel(600, 260) == frame->get_pixel(600, 150);
+    bool single = frame->get_pixel(200, 500) != background;
+    for (int y = 451; y < 550; y++) {
+        for (int x = 101; x < 300; x++) {
+            single = single && frame->get_pixel(x, y) == frame->get_pixel(200, 500);
+        }
+    }
+    std::cout << "Even-odd star " << (even_odd ? "match" : "differ") << ", non-zero star "
+              << (non_zero ? "match" : "differ") << ", shared edge "
+              << (single ? "blended once" : "blended twice") << std::endl;
+    assert(even_odd && non_zero && single);
+}
+
+void convex_polygon_test() {
+    // 凸性判断：重复、共线的顶点不影响，自相交和凹多边形不是凸多边形
+    assert(is_convex_polygon(make_polygon({{0, 0}, {10, 0}, {10, 0}, {20, 0}, {20, 20}})));
+    assert(!is_convex_polygon(make_polygon({{0, 0}, {10, 0}, {5, 5}, {10, 10}, {0, 10}})));
+    assert(!is_convex_polygon(
+        make_polygon({{200, 100}, {290, 380}, {50, 210}, {350, 210}, {110, 380}})));
+    assert(!is_convex_polygon(make_polygon({{0, 0}, {10, 10}, {0, 0}})));
+
+    // 旋转的半透明四边形和三角形，裁剪后仍是凸多边形
+    auto options = engine.get_global_options();
+    options.clip = {true, make_rectangle({100, 100}, {700, 500})};
+    engine.set_global_options(options);
+    for (int i = 0; i < 12; i++) {
+        engine.set_pen_options({.color = Colors::White, .fill_color = {i / 12.0f, 0.5, 1, 0.5}});
+        engine.add_primitive(make_rotate(i * 0.25f, {400, 300}));
+        if (i % 2 == 0) {
+            engine.add_primitive(make_polygon({{150, 250}, {650, 250}, {650, 350}, {150, 350}}));
+        } else {
+            engine.add_primitive(make_polygon({{400, 20}, {520, 300}, {280, 300}}));
+        }
+    }
+
+    // 凸多边形的快速路径与通用的扫描线算法给出相同的像素
+    // 包括带水平边的多边形、重复和共线的顶点、被裁剪窗口截断的多边形
+    std::vector<Polygon> polygons = {
+        make_polygon({{150, 250}, {650, 250}, {650, 350}, {150, 350}}),
+        make_polygon({{300, 100}, {500, 100}, {600, 400}, {200, 400}}),
+        make_polygon({{400, 20}, {520, 300}, {280, 300}}),
+        make_polygon({{100, 100}, {100, 100}, {300, 100}, {500, 100}, {500, 300}, {100, 300}}),
+        make_polygon({{-200, 300}, {400, -100}, {1000, 300}, {400, 900}}),
+        make_polygon({{10, 10}, {11, 10}, {11, 11}}),
+    };
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> unit(0, 1);
+    while (polygons.size() < 200) {
+        // 圆上按极角排列的随机点，取整后仍为凸多边形的才保留
+        const int count = 3 + static_cast<int>(unit(gen) * 6);
+        std::vector<double> angles(count);
+        for (auto &angle : angles) {
+            angle = unit(gen) * 2 * std::numbers::pi;
+        }
+        std::sort(angles.begin(), angles.end());
+        const double cx = unit(gen) * WIDTH;
+        const double cy = unit(gen) * HEIGHT;
+        const double radius = 5 + unit(gen) * 300;
+        Polygon polygon;
+        for (const auto angle : angles) {
+            polygon.push_back({static_cast<int>(std::lround(cx + radius * std::cos(angle))),
+                static_cast<int>(std::lround(cy + radius * std::sin(angle)))});
+        }
+        if (is_convex_polygon(polygon)) {
+            polygons.push_back(std::move(polygon));
+        }
+    }
+    using Span = std::tuple<int, int, int>;
+    const auto spans = [](const Polygon &polygon, const Bounds &clip, bool convex) {
+        ScanlineRasterizer rasterizer(std::pmr::new_delete_resource());
+        rasterizer.add_contour(polygon);
+        std::vector<Span> result;
+        const auto emit = [&result](int y, int x0, int x1) { result.emplace_back(y, x0, x1); };
+        if (convex) {
+            rasterizer.rasterize_convex(clip, emit);
+        } else {
+            rasterizer.rasterize(clip, ScanlineRasterizer::FillRule::EVEN_ODD, emit);
+        }
+        return result;
+    };
+    const Bounds clips[] = {make_bounds(0, 0, WIDTH, HEIGHT), make_bounds(100, 100, 700, 500),
+        make_bounds(390, 290, 410, 310)};
+    bool same = true;
+    for (const auto &polygon : polygons) {
+        assert(is_convex_polygon(polygon));
+        for (const auto &clip : clips) {
+            same = same && spans(polygon, clip, true) == spans(polygon, clip, false);
+        }
+    }
+    std::cout << "Convex fast path " << (same ? "match" : "differ") << " scanline fill"
+              << std::endl;
+    assert(same);
+}
+
+void fill_connectivity_test() {
+    // 上边有多个 V 形缺口的凹区域，扫描线种子填充与逐像素的四连通广度优先搜索结果一致
+    engine.set_pen_options({.color = Colors::White, .fill_color = {0, 0, 0, 0}});
+    Polygon comb{{100, 590}, {700, 590}};
+    for (int x = 700; x > 100; x -= 100) {
+        comb.insert(comb.end(), {{x, 480}, {x - 30, 480}, {x - 50, 560}, {x - 70, 480}});
+    }
+    comb.push_back({100, 480});
+    engine.add_primitive(comb);
+    engine.render();
+    const auto snapshot = [] {
+        const auto frame = engine.get_frame();
+        std::vector<uint32_t> pixels;
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                pixels.push_back(frame->get_pixel(x, y));
+            }
+        }
+        return pixels;
+    };
+    const auto before = snapshot();
+    const Point seed{110, 585};
+    std::vector<bool> reached(before.size(), false);
+    std::vector<Point> queue{seed};
+    reached[seed.y * WIDTH + seed.x] = true;
+    for (size_t i = 0; i < queue.size(); i++) {
+        const auto p = queue[i];
+        for (const auto &[dx, dy] : {std::pair{1, 0}, {-1, 0}, {0, 1}, {0, -1}}) {
+            const int x = p.x + dx;
+            const int y = p.y + dy;
+            if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+                continue;
+            }
+            const auto index = y * WIDTH + x;
+            if (!reached[index] && before[index] == before[seed.y * WIDTH + seed.x]) {
+                reached[index] = true;
+                queue.push_back({x, y});
+            }
+        }
+    }
+    engine.set_pen_options({.color = Colors::White, .fill_color = Colors::Red});
+    engine.add_primitive(make_fill(seed));
+    engine.render();
+    const auto after = snapshot();
+    const auto background = before[0];
+    bool same = true;
+    for (size_t i = 0; i < before.size(); i++) {
+        same = same && (after[i] != before[i]) == reached[i];
+    }
+
+    // 单像素宽的斜线围成的菱形，斜线上的像素只在对角相邻
+    engine.set_pen_options({.color = Colors::White});
+    for (const int cx : {200, 600}) {
+        engine.add_primitive(make_line({cx, 150}, {cx + 150, 300}));
+        engine.add_primitive(make_line({cx + 150, 300}, {cx, 450}));
+        engine.add_primitive(make_line({cx, 450}, {cx - 150, 300}));
+        engine.add_primitive(make_line({cx - 150, 300}, {cx, 150}));
+    }
+    // 八连通填充从斜线的缝隙漏到菱形外，填满整个画面
+    engine.set_pen_options({.color = Colors::White, .fill_color = Colors::Blue});
+    engine.add_primitive(make_fill({600, 300}, Fill::Connectivity::EIGHT));
+    // 四连通填充停在斜线围成的边界内
+    engine.set_pen_options({.color = Colors::White, .fill_color = Colors::Green});
+    engine.add_primitive(make_fill({200, 300}));
+    engine.render();
+
+    // 四连通填充只改变菱形内部，菱形外仍是八连通填充漏出的颜色
+    const auto frame = engine.get_frame();
+    const bool leaked = frame->get_pixel(10, 10) == frame->get_pixel(600, 300) &&
+                        frame->get_pixel(10, 10) != background;
+    const bool bounded = frame->get_pixel(200, 300) != frame->get_pixel(600, 300) &&
+                         frame->get_pixel(200, 140) == frame->get_pixel(10, 10) &&
+                         frame->get_pixel(40, 300) == frame->get_pixel(10, 10);
+    std::cout << "Span fill " << (same ? "matches" : "differs from") << " 4-neighbour reference, "
+              << "8-connected fill " << (leaked ? "leaked" : "stopped") << ", 4-connected fill "
+              << (bounded ? "stopped" : "leaked") << std::endl;
+    assert(same && leaked && bounded);
+}
+
+void stroke_test() {
+    using LineCap = PenOptions::LineCap;
+    using LineJoin = PenOptions::LineJoin;
+    const Color translucent{1.0f, 0.5f, 0.0f, 0.5f};
+    const Color clear{0.0f, 0.0f, 0.0f, 0.0f};
+    // 三种拐角：尖角、斜角、圆角，锐角处的尖角超过上限时改为斜角
+    const LineJoin joins[] = {LineJoin::MITER, LineJoin::BEVEL, LineJoin::ROUND};
+    const LineCap caps[] = {LineCap::BUTT, LineCap::SQUARE, LineCap::ROUND};
+    for (int i = 0; i < 3; i++) {
+        const int x = 60 + i * 250;
+        engine.set_pen_options({.color = translucent,
+            .fill_color = clear,
+            .width = 24,
+            .cap = caps[i],
+            .join = joins[i]});
+        engine.add_primitive(make_polygon({{x, 60}, {x + 180, 60}, {x + 40, 180}, {x + 180, 180}}));
+        // 开放的折线：自相交的贝塞尔曲线，交叉处半透明只混合一次
+        engine.add_primitive(
+            make_bezier_curve({{x, 220}, {x + 260, 400}, {x - 80, 400}, {x + 180, 220}}));
+    }
+    // 宽虚线：线型沿整个圆连续计数
+    engine.set_pen_options({.color = Colors::Cyan,
+        .width = 9,
+        .type = PenOptions::LineType::DASH_DOT,
+        .dash = 6,
+        .cap = LineCap::ROUND});
+    engine.add_primitive(make_circle_center_radius({200, 480}, 80));
+    // 宽的斜线段和矩形边线
+    engine.set_pen_options({.color = Colors::White, .width = 15, .cap = LineCap::BUTT});
+    engine.add_primitive(make_line({360, 420}, {560, 560}));
+    engine.set_pen_options({.color = translucent, .fill_color = Colors::Blue, .width = 12});
+    engine.add_primitive(make_rectangle({600, 420}, {760, 560}));
+    // 三种端点的水平线段：平头止于端点，方头延伸半个线宽，圆头是半径为半个线宽的半圆
+    for (int i = 0; i < 3; i++) {
+        engine.set_pen_options({.color = Colors::White, .width = 10, .cap = caps[i]});
+        engine.add_primitive(make_line({100 + i * 200, 585}, {200 + i * 200, 585}));
+    }
+    engine.render();
+
+    const auto frame = engine.get_frame();
+    const auto background = frame->get_pixel(0, HEIGHT - 1);
+    const auto covered = [&](int x, int y) { return frame->get_pixel(x, y) != background; };
+    // 尖角拐角附近两条线段重叠的像素与只被一条线段覆盖的像素颜色相同
+    bool single = true;
+    for (int i = 0; i < 3; i++) {
+        const int x = 60 + i * 250;
+        single = single && covered(x + 90, 60) &&
+                 frame->get_pixel(x + 172, 62) == frame->get_pixel(x + 90, 60);
+    }
+    const bool butt = covered(100, 585) && !covered(99, 585) && covered(199, 585) &&
+                      !covered(200, 585) && covered(150, 580) && !covered(150, 579) &&
+                      covered(150, 589) && !covered(150, 590);
+    const bool square = covered(295, 585) && !covered(294, 585) && covered(404, 585) &&
+                        !covered(405, 585) && covered(295, 580) && covered(404, 589);
+    const bool round = covered(496, 585) && !covered(494, 585) && covered(604, 585) &&
+                       !covered(606, 585) && covered(500, 581) && !covered(496, 581);
+    std::cout << "Overlapping joins " << (single ? "blended once" : "blended twice")
+              << ", butt cap " << (butt ? "match" : "differ") << ", square cap "
+              << (square ? "match" : "differ") << ", round cap " << (round ? "match" : "differ")
+              << std::endl;
+    assert(single && butt && square && round);
+}
+
+void geometry_transform_test() {
+    // 变换在栅格化前作用于几何，放大后没有空洞，线宽不随缩放改变
+    engine.set_pen_options({.color = Colors::White, .fill_color = Colors::Blue});
+    // 放大 4 倍并旋转的矩形变为多边形
+    engine.add_primitive(make_scale(4, 4, {0, 0}));
+    engine.add_primitive(make_rotate(0.3f, {0, 0}));
+    engine.add_primitive(make_rectangle({10, 10}, {40, 30}));
+    // 非均匀缩放后的圆变为 B 样条曲线，旋转后的椭圆变为多边形
+    engine.add_primitive(make_scale(3, 1, {500, 100}));
+    engine.add_primitive(make_circle_center_radius({500, 100}, 60));
+    engine.add_primitive(make_rotate(0.6f, {200, 400}));
+    engine.add_primitive(make_ellipse({200, 400}, 150, 60));
+    // 旋转后跨过 ±π 的圆弧变为 B 样条曲线，平移后的圆弧仍是圆弧
+    engine.set_pen_options(
+        {.color = Colors::Yellow, .width = 5, .cap = PenOptions::LineCap::ROUND});
+    engine.add_primitive(make_rotate(2.5f, {550, 400}));
+    engine.add_primitive(make_arc_center_radius_angle({550, 400}, 120, 0, 1.5f));
+    engine.add_primitive(make_translate(0, 20));
+    engine.add_primitive(make_arc_center_radius_angle({550, 400}, 120, 0, 1.5f));
+    // B 样条曲线变换控制点
+    engine.set_pen_options({.color = Colors::Green});
+    engine.add_primitive(make_scale(1, 2, {0, 300}));
+    engine.add_primitive(make_bspline_curve(
+        {{400, 250}, {500, 330}, {600, 250}, {700, 330}}, {0, 0, 0, 0, 1, 1, 1, 1}));
+    engine.render();
+
+    const auto frame = engine.get_frame();
+    const auto background = frame->get_pixel(WIDTH - 1, HEIGHT - 1);
+    // 矩形放大为 [40, 160] × [40, 120] 后旋转，离边界 2 个像素以内的内部像素都是填充色
+    const double c = std::cos(0.3), s = std::sin(0.3);
+    const auto fill = frame->get_pixel(72, 106);
+    bool filled = fill != background;
+    for (int y = 0; y < 200; y++) {
+        for (int x = 0; x < 200; x++) {
+            const double u = x * c + y * s;
+            const double v = y * c - x * s;
+            if (u > 42 && u < 158 && v > 42 && v < 118) {
+                filled = filled && frame->get_pixel(x, y) == fill;
+            }
+        }
+    }
+    // 区域内绘制的像素的包围盒与预期相差不超过 1.5 个像素
+    const auto bounded = [&](int x0, int y0, int x1, int y1, double min_x, double min_y,
+                             double max_x, double max_y) {
+        int left = x1, top = y1, right = x0, bottom = y0;
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                if (frame->get_pixel(x, y) != background) {
+                    left = std::min(left, x);
+                    top = std::min(top, y);
+                    right = std::max(right, x);
+                    bottom = std::max(bottom, y);
+                }
+            }
+        }
+        return std::abs(left - min_x) <= 1.5 && std::abs(top - min_y) <= 1.5 &&
+               std::abs(right - max_x) <= 1.5 && std::abs(bottom - max_y) <= 1.5;
+    };
+    // 横向放大 3 倍的圆是半径为 180 和 60 的椭圆
+    const bool circle = bounded(250, 0, 750, 190, 320, 40, 680, 160);
+    // 旋转 θ 的椭圆的包围盒半宽为 √(a²cos²θ + b²sin²θ)，半高为 √(a²sin²θ + b²cos²θ)
+    const double cr = std::cos(0.6), sr = std::sin(0.6);
+    const double half_width = std::sqrt(150 * 150 * cr * cr + 60 * 60 * sr * sr);
+    const double half_height = std::sqrt(150 * 150 * sr * sr + 60 * 60 * cr * cr);
+    const bool ellipse = bounded(0, 250, 400, 580, 200 - half_width, 400 - half_height,
+        200 + half_width, 400 + half_height);
+    std::cout << "Scaled rectangle " << (filled ? "filled" : "has holes") << ", scaled circle "
+              << (circle ? "match" : "differ") << ", rotated ellipse "
+              << (ellipse ? "match" : "differ") << std::endl;
+    assert(filled && circle && ellipse);
+}
@@ -9,11 +9,17 @@
 
 #include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
 
+#include "FramePublisher.h"
 #include "engine.hpp"
 
 using RenderCore::RenderEngine;
@@ -24,45 +30,157 @@ class EngineManager {
    public:
     struct EngineMutex {
         RenderEngine engine;
+        // 串行化渲染、取帧等渲染接口
+        // 编辑图元、读取图元快照由引擎内部同步，不需要持有此锁
         std::mutex mutex;
 
         EngineMutex() = default;
 
-        EngineMutex(int width, int height) : engine(width, height) {}
+        EngineMutex(int width, int height, int render_threads)
+            : engine(width, height, render_threads) {}
     };
 
    private:
-    std::unordered_map<std::string, std::shared_ptr<EngineMutex>> engines_;
-    std::unordered_map<std::string, boost::asio::steady_timer> timers_;
-    std::mutex map_mutex_;
+    // 注册表中的一项
+    struct EngineEntry {
+        std::shared_ptr<EngineMutex> engine;
+        std::shared_ptr<FramePublisher> publisher;
+        // 最后一次访问的时间（steady_clock 的计数），访问时只写入这个值
+        std::atomic<std::chrono::steady_clock::rep> last_access{0};
 
-    static constexpr std::chrono::seconds engine_timeout = std::chrono::seconds(30);
-    static constexpr int timer_thread_count = 4;
+        void touch() {
+            const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            last_access.store(now, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::chrono::steady_clock::time_point get_last_access() const {
+            return std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(last_access.load(std::memory_order_relaxed)));
+        }
+    };
+
+    // 按引擎名哈希分片，每个分片一把读写锁
+    // 查找只加读锁，不同引擎的查找互不阻塞，创建和移除只锁住所在的分片
+    struct Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<EngineEntry>> entries;
+    };
+
+    static constexpr size_t shard_count = 16;
+    std::array<Shard, shard_count> shards_;
+
+    // 引擎空闲超过此时间后被移除
+    std::atomic<std::chrono::milliseconds> engine_timeout_{std::chrono::seconds(30)};
+
+    // 每个引擎的渲染线程数
+    int render_threads_{1};
+
+    // 帧发布者定时渲染所在的 io_context，由服务器设置，未设置时使用 ioc_
+    boost::asio::io_context *publish_ioc_{nullptr};
 
-    std::vector<std::thread> threads_;
-    boost::asio::io_context ioc_{timer_thread_count};
+    // 只运行空闲引擎的检查定时器
+    std::thread sweep_thread_;
+    boost::asio::io_context ioc_{1};
     boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_guard_{
         ioc_.get_executor()};
 
-    void reset_timer(const std::string &name) {
-        if (timers_.find(name) == timers_.end()) {
-            timers_.emplace(name, boost::asio::steady_timer(ioc_));
+    // 定期移除空闲引擎
+    // 只有一个定时器，每隔超时时间的 1/4 检查一次，引擎最多在超时后再多保留 1/4 的时间
+    boost::asio::steady_timer sweep_timer_{ioc_};
+
+    Shard &shard_of(const std::string &name) {
+        return shards_[std::hash<std::string>{}(name) % shard_count];
+    }
+
+    // 查找引擎，touch 为 true 时刷新超时时间
+    std::shared_ptr<EngineEntry> find_entry(const std::string &name, bool touch) {
+        auto &shard = shard_of(name);
+        std::shared_ptr<EngineEntry> entry;
+        {
+            std::shared_lock lock(shard.mutex);
+            auto it = shard.entries.find(name);
+            if (it == shard.entries.end()) {
+                return nullptr;
+            }
+            entry = it->second;
+        }
+        if (touch) {
+            entry->touch();
         }
+        return entry;
+    }
+
+    // 渲染引擎并取得当前帧，由帧发布者调用
+    bool render_frame(const std::string &name, PublishedFrame &frame) {
+        auto engine_with_mutex = get_engine_with_mutex(name);
+        if (engine_with_mutex == nullptr) {
+            logger::error("Engine not found: {}, stop publishing frame", name);
+            return false;
+        }
+        std::lock_guard lock(engine_with_mutex->mutex);
+        // 测量渲染时间
+        auto start = std::chrono::steady_clock::now();
+        engine_with_mutex->engine.render();
+        auto end = std::chrono::steady_clock::now();
+        logger::trace("Render time: {} ms",
+            std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+        // 只持有快照的引用，不复制像素，引擎之后渲染到其他缓冲区
+        frame.version = engine_with_mutex->engine.get_frame_version();
+        frame.frame = engine_with_mutex->engine.get_frame();
+        return frame.frame != nullptr;
+    }
+
+    std::chrono::milliseconds sweep_interval() const {
+        return std::max(engine_timeout_.load() / 4, std::chrono::milliseconds(100));
+    }
 
-        timers_.at(name).expires_after(engine_timeout);
-        timers_.at(name).async_wait([this, name](const boost::system::error_code &ec) {
+    void schedule_sweep() {
+        sweep_timer_.expires_after(sweep_interval());
+        sweep_timer_.async_wait([this](const boost::system::error_code &ec) {
             if (!ec) {
-                logger::info("Engine {} timeout", name);
-                remove_engine(name);
+                sweep();
+                schedule_sweep();
             }
         });
     }
 
+    // 移除空闲超时的引擎
+    void sweep() {
+        const auto timeout = engine_timeout_.load();
+        std::vector<std::string> idle;
+        for (auto &shard : shards_) {
+            idle.clear();
+            const auto deadline = std::chrono::steady_clock::now() - timeout;
+            {
+                std::shared_lock lock(shard.mutex);
+                for (const auto &[name, entry] : shard.entries) {
+                    if (entry->get_last_access() < deadline) {
+                        idle.push_back(name);
+                    }
+                }
+            }
+            for (const auto &name : idle) {
+                // 加写锁后再检查一次，期间可能又被访问
+                std::shared_ptr<EngineEntry> entry;
+                {
+                    std::unique_lock lock(shard.mutex);
+                    auto it = shard.entries.find(name);
+                    if (it == shard.entries.end() || it->second->get_last_access() >= deadline) {
+                        continue;
+                    }
+                    entry = std::move(it->second);
+                    shard.entries.erase(it);
+                }
+                logger::info("Engine {} timeout", name);
+                entry->publisher->stop();
+            }
+        }
+    }
+
    public:
     EngineManager() {
-        for (int i = 0; i < timer_thread_count; i++) {
-            threads_.emplace_back([this] { ioc_.run(); });
-        }
+        schedule_sweep();
+        sweep_thread_ = std::thread([this] { ioc_.run(); });
     }
 
     static EngineManager &get_instance() {
@@ -70,45 +188,74 @@ class EngineManager {
         return instance;
     }
 
+    // 设置之后创建的引擎使用的渲染线程数
+    void set_render_threads(int threads) { render_threads_ = threads; }
+
+    // 设置之后创建的引擎渲染、发布帧所在的 io_context，通常为服务器的 io_context
+    void set_publish_io_context(boost::asio::io_context &ioc) { publish_ioc_ = &ioc; }
+
+    // 设置引擎的空闲超时时间，下一次检查时生效
+    void set_engine_timeout(std::chrono::milliseconds timeout) { engine_timeout_ = timeout; }
+
     void create_engine(const std::string &name, int width, int height) {
-        std::lock_guard<std::mutex> lock(map_mutex_);
-        if (engines_.find(name) != engines_.end()) {
-            logger::warn("Engine {} already exists", name);
-            return;
+        auto &shard = shard_of(name);
+        {
+            std::unique_lock lock(shard.mutex);
+            if (shard.entries.find(name) != shard.entries.end()) {
+                logger::warn("Engine {} already exists", name);
+                return;
+            }
+            logger::info("Create engine: {}", name);
+            auto entry = std::make_shared<EngineEntry>();
+            entry->touch();
+            entry->engine = std::make_shared<EngineMutex>(width, height, render_threads_);
+            entry->publisher = std::make_shared<FramePublisher>(publish_ioc_ ? *publish_ioc_ : ioc_,
+                [this, name](PublishedFrame &frame) { return render_frame(name, frame); });
+            shard.entries.emplace(name, std::move(entry));
         }
-        logger::info("Create engine: {}", name);
-        engines_[name] = std::make_shared<EngineMutex>(width, height);
-        reset_timer(name);
     }
 
-    bool check_engine(const std::string &name) {
-        std::lock_guard<std::mutex> lock(map_mutex_);
-        return engines_.find(name) != engines_.end();
-    }
+    bool check_engine(const std::string &name) { return find_entry(name, false) != nullptr; }
 
+    // 查找引擎并刷新超时时间，不存在时返回 nullptr
     std::shared_ptr<EngineMutex> get_engine_with_mutex(const std::string &name) {
-        std::lock_guard<std::mutex> lock(map_mutex_);
-        if (engines_.find(name) == engines_.end()) {
-            return nullptr;
-        }
-        reset_timer(name);
-        return engines_[name];
+        auto entry = find_entry(name, true);
+        return entry ? entry->engine : nullptr;
+    }
+
+    // 取得引擎的帧发布者，不刷新引擎的超时时间
+    std::shared_ptr<FramePublisher> get_publisher(const std::string &name) {
+        auto entry = find_entry(name, false);
+        return entry ? entry->publisher : nullptr;
     }
 
     void remove_engine(const std::string &name) {
-        std::lock_guard<std::mutex> lock(map_mutex_);
-        logger::info("Remove engine: {}", name);
-        engines_.erase(name);
+        auto &shard = shard_of(name);
+        std::shared_ptr<EngineEntry> entry;
+        {
+            std::unique_lock lock(shard.mutex);
+            auto it = shard.entries.find(name);
+            if (it == shard.entries.end()) {
+                return;
+            }
+            logger::info("Remove engine: {}", name);
+            entry = std::move(it->second);
+            shard.entries.erase(it);
+        }
+        entry->publisher->stop();
     }
 
     void shutdown() {
+        sweep_timer_.cancel();
         work_guard_.reset();
         ioc_.stop();
-        for (auto &t : threads_) {
-            t.join();
+        if (sweep_thread_.joinable()) {
+            sweep_thread_.join();
+        }
+        for (auto &shard : shards_) {
+            std::unique_lock lock(shard.mutex);
+            shard.entries.clear();
         }
-        engines_.clear();
-        timers_.clear();
     }
 };
 
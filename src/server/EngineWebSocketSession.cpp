@@ -4,12 +4,30 @@
 
 #include "EngineWebSocketSession.h"
 
+#include <charconv>
+#include <optional>
 #include <string_view>
 
 extern void fail(boost::system::error_code ec, char const *what);
 
+namespace {
+
+// 解析消息中的整数参数，格式不正确或超出范围时返回空
+template <typename T>
+std::optional<T> parse_number(std::string_view text) {
+    T value{};
+    const auto end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+}  // namespace
+
 EngineWebSocketSession::EngineWebSocketSession(tcp::socket socket)
-    : ws_(std::move(socket)), timer_(ws_.get_executor()) {}
+    : strand_(boost::asio::make_strand(socket.get_executor())), ws_(std::move(socket)) {}
 
 void EngineWebSocketSession::run(const http::request<http::string_body> &req) {
     // find the engine name
@@ -20,101 +38,217 @@ void EngineWebSocketSession::run(const http::request<http::string_body> &req) {
     }
     engine_name_ = req.target().substr(pos + 1);
     logger::debug("Engine name: {}", engine_name_);
-    if (!EngineManager::get_instance().check_engine(engine_name_)) {
+    publisher_ = EngineManager::get_instance().get_publisher(engine_name_);
+    if (!publisher_) {
         logger::error("Engine not found: {}", engine_name_);
         return;
     }
     ws_.set_option(websocket::permessage_deflate{.server_enable = true, .client_enable = true});
-    ws_.async_accept(req, [self = shared_from_this()](boost::system::error_code) {
-        self->ws_.binary(true);
-        self->ws_.async_read(self->buffer_,
-            boost::beast::bind_front_handler(&EngineWebSocketSession::on_read, self));
-    });
+    ws_.async_accept(req,
+        boost::asio::bind_executor(strand_, [self = shared_from_this()](boost::system::error_code) {
+            self->ws_.binary(true);
+            self->do_read();
+        }));
+}
+
+void EngineWebSocketSession::do_read() {
+    ws_.async_read(buffer_, boost::asio::bind_executor(strand_,
+                                boost::beast::bind_front_handler(
+                                    &EngineWebSocketSession::on_read, shared_from_this())));
 }
 
 void EngineWebSocketSession::set_fps(int fps) {
     fps_ = fps;
-    timer_.cancel();
-    if (fps_ != 0) {
-        timer_.expires_after(std::chrono::milliseconds(1000 / fps_));
-        timer_.async_wait(boost::beast::bind_front_handler(
-            &EngineWebSocketSession::on_timer, shared_from_this()));
+    // 由引擎的帧发布者定时渲染，同一引擎的所有会话共享一次渲染
+    publisher_->subscribe(shared_from_this(), fps_);
+}
+
+void EngineWebSocketSession::set_encoding(const std::string &encoding) {
+    if (encoding == "delta") {
+        encoding_ = Encoding::DELTA;
+    } else if (encoding == "raw") {
+        encoding_ = Encoding::RAW;
+    } else if (encoding == "qoi") {
+        encoding_ = Encoding::QOI;
+    } else if (encoding == "png") {
+        encoding_ = Encoding::PNG;
+    } else {
+        logger::warn("Unknown frame encoding: {}", encoding);
+        return;
+    }
+    // 切换编码后从关键帧开始
+    base_.reset();
+    key_requested_ = true;
+    unacked_.clear();
+    lagging_frames_ = 0;
+}
+
+void EngineWebSocketSession::on_ack(uint64_t version) {
+    while (!unacked_.empty() && unacked_.front() <= version) {
+        unacked_.pop_front();
+    }
+}
+
+void EngineWebSocketSession::apply_binary_operations() {
+    const auto data = buffer_.cdata();
+    std::vector<PrimitiveOperation> operations;
+    try {
+        operations = decode_primitive_operations(data.data(), data.size());
+    } catch (const std::exception &e) {
+        logger::error("Invalid primitive operations: {}", e.what());
+        return;
+    }
+    auto engine_with_mutex = EngineManager::get_instance().get_engine_with_mutex(engine_name_);
+    if (engine_with_mutex == nullptr) {
+        logger::error("Engine not found: {}", engine_name_);
+        return;
+    }
+    std::vector<size_t> indices;
+    std::optional<size_t> failed;
+    {
+        auto lock = engine_with_mutex->engine.lock_edits();
+        failed = apply_primitive_operations(engine_with_mutex->engine, operations, indices);
+    }
+    if (failed) {
+        logger::error("Index out of range in primitive operation {}", *failed);
+        return;
+    }
+    logger::trace("Applied {} primitive operations", operations.size());
+}
+
+void EngineWebSocketSession::close() {
+    if (publisher_) {
+        publisher_->unsubscribe(shared_from_this());
     }
 }
 
 void EngineWebSocketSession::on_read(boost::system::error_code ec, std::size_t bytes_transferred) {
     boost::ignore_unused(bytes_transferred);
     if (ec) {
+        close();
         if (ec == boost::beast::websocket::error::closed) {
             return;
         }
         fail(ec, "read");
         return;
     }
+    if (ws_.got_binary()) {
+        // 二进制消息为一批图元操作，见 serialize_binary.h
+        apply_binary_operations();
+        buffer_.consume(buffer_.size());
+        do_read();
+        return;
+    }
     const std::string message = boost::beast::buffers_to_string(buffer_.data());
     buffer_.consume(buffer_.size());
     logger::debug("Received message: {}", message);
 
     if (message == "get") {
-        send_frame();
+        publisher_->request_frame(shared_from_this());
     }
     if (message.starts_with("set_fps")) {
         auto pos = message.find(' ');
         if (pos != std::string::npos) {
-            set_fps(std::stoi(message.substr(pos + 1)));
+            const auto fps = parse_number<int>(std::string_view(message).substr(pos + 1));
+            if (!fps) {
+                logger::warn("Invalid fps: {}", message);
+            } else {
+                set_fps(*fps);
+            }
         }
     }
-    ws_.async_read(buffer_,
-        boost::beast::bind_front_handler(&EngineWebSocketSession::on_read, shared_from_this()));
-}
-
-void EngineWebSocketSession::on_timer(boost::system::error_code ec) {
-    if (ec) {
-        if (ec == boost::asio::error::operation_aborted) {
-            return;
+    if (message.starts_with("set_encoding")) {
+        auto pos = message.find(' ');
+        if (pos != std::string::npos) {
+            set_encoding(message.substr(pos + 1));
+        }
+    }
+    if (message.starts_with("ack")) {
+        auto pos = message.find(' ');
+        if (pos != std::string::npos) {
+            const auto version = parse_number<uint64_t>(std::string_view(message).substr(pos + 1));
+            if (!version) {
+                logger::warn("Invalid ack: {}", message);
+            } else {
+                on_ack(*version);
+            }
         }
-        fail(ec, "timer");
-        return;
     }
-    send_frame();
-    if (fps_ != 0) {
-        timer_.expires_after(std::chrono::milliseconds(1000 / fps_));
-        timer_.async_wait(boost::beast::bind_front_handler(
-            &EngineWebSocketSession::on_timer, shared_from_this()));
+    if (message == "refresh") {
+        // 客户端丢失了基准帧，下一帧发送关键帧
+        key_requested_ = true;
+        publisher_->request_frame(shared_from_this());
     }
+    do_read();
 }
 
-void EngineWebSocketSession::send_frame() {
-    auto engine_with_mutex = EngineManager::get_instance().get_engine_with_mutex(engine_name_);
-    if (engine_with_mutex == nullptr) {
-        logger::error("Engine not found: {}, stop sending frame", engine_name_);
-        timer_.cancel();
+void EngineWebSocketSession::on_frame(const std::shared_ptr<const PublishedFrame> &frame) {
+    // 在发布者的线程上调用，切换到会话的 strand
+    boost::asio::post(strand_,
+        [self = shared_from_this(), frame] { self->send_frame(frame); });
+}
+
+void EngineWebSocketSession::send_frame(const std::shared_ptr<const PublishedFrame> &frame) {
+    // 上一帧还在发送，丢弃这一帧，不影响其他会话
+    if (write_in_progress_) {
+        logger::trace("Write in progress, frame {} dropped", frame->version);
         return;
     }
-    std::lock_guard lock(engine_with_mutex->mutex);
-    // 发送帧
-    if (write_in_progress_) {
-        logger::trace("Write in progress, frame dropped");
+    if (encoding_ == Encoding::RAW) {
+        frame_ = frame;
+        write_in_progress_ = true;
+        ws_.async_write(boost::asio::buffer(frame_->frame->data(), frame_->frame->size()),
+            boost::asio::bind_executor(strand_, boost::beast::bind_front_handler(
+                &EngineWebSocketSession::on_write, shared_from_this())));
+        return;
+    }
+    if (encoding_ == Encoding::QOI || encoding_ == Encoding::PNG) {
+        // 编码结果写入会话自己的缓冲区，发送完成前不会再次编码
+        const auto format = encoding_ == Encoding::QOI ? RenderCore::ImageFormat::QOI
+                                                       : RenderCore::ImageFormat::PNG;
+        const auto &buffer = image_encoder_.encode(*frame->frame, format);
+        write_in_progress_ = true;
+        ws_.async_write(boost::asio::buffer(buffer),
+            boost::asio::bind_executor(strand_, boost::beast::bind_front_handler(
+                &EngineWebSocketSession::on_write, shared_from_this())));
         return;
     }
-    // 测量渲染时间
-    auto start = std::chrono::steady_clock::now();
-    engine_with_mutex->engine.render();
-    auto end = std::chrono::steady_clock::now();
-    logger::trace("Render time: {} ms",
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
-    frame_buffer_ = engine_with_mutex->engine.get_frame_buffer();
+    // 客户端处理不过来，丢弃这一帧，之后的差量帧仍以 base_ 为基准
+    if (unacked_.size() >= max_unacked_frames && !key_requested_) {
+        if (++lagging_frames_ < max_lagging_frames) {
+            logger::trace("Too many unacknowledged frames, frame {} dropped", frame->version);
+            return;
+        }
+        // 确认迟迟未到，客户端可能已丢失状态，发送关键帧重新同步
+        logger::debug("Acknowledgements lagging, sending key frame {}", frame->version);
+        key_requested_ = true;
+        unacked_.clear();
+    }
+    lagging_frames_ = 0;
+    const bool key = key_requested_ || !base_ || frames_since_key_ >= keyframe_interval ||
+                     base_->frame->width() != frame->frame->width() ||
+                     base_->frame->height() != frame->frame->height();
+    const auto &buffer = key ? encoder_.encode_key(*frame->frame, frame->version)
+                             : encoder_.encode_delta(*base_->frame, base_->version,
+                                   *frame->frame, frame->version);
+    key_requested_ = false;
+    frames_since_key_ = key ? 0 : frames_since_key_ + 1;
+    // 消息按顺序到达，客户端收到这一帧时一定已持有 base_，见 base_ 的说明
+    base_ = frame;
+    unacked_.push_back(frame->version);
     write_in_progress_ = true;
-    ws_.async_write(boost::asio::buffer(frame_buffer_.data(), frame_buffer_.size()),
-        boost::beast::bind_front_handler(&EngineWebSocketSession::on_write, shared_from_this()));
+    ws_.async_write(boost::asio::buffer(buffer),
+        boost::asio::bind_executor(strand_, boost::beast::bind_front_handler(
+            &EngineWebSocketSession::on_write, shared_from_this())));
 }
 
 void EngineWebSocketSession::on_write(boost::system::error_code ec, std::size_t bytes_transferred) {
     boost::ignore_unused(bytes_transferred);
+    frame_.reset();
     if (ec) {
         fail(ec, "write");
         write_in_progress_ = false;
-        timer_.cancel();
+        close();
         return;
     }
     write_in_progress_ = false;
@@ -5,38 +5,89 @@
 #ifndef RENDERENGINE_ENGINEWEBSOCKETSESSION_H
 #define RENDERENGINE_ENGINEWEBSOCKETSESSION_H
 
+#include <deque>
+
 #include "EngineManager.h"
 #include "Server.h"
 #include "engine.hpp"
+#include "frame_encoder.hpp"
+#include "image_encoder.hpp"
+#include "serialize/serialize_binary.h"
 
+using RenderCore::FrameEncoder;
+using RenderCore::ImageEncoder;
 using RenderCore::RenderEngine;
 namespace websocket = boost::beast::websocket;
 namespace http = boost::beast::http;
 
-class EngineWebSocketSession : public std::enable_shared_from_this<EngineWebSocketSession> {
+class EngineWebSocketSession : public FrameSubscriber,
+                               public std::enable_shared_from_this<EngineWebSocketSession> {
     std::string engine_name_;
+    std::shared_ptr<FramePublisher> publisher_;
 
+    // 读写回调、命令处理和帧发送都在 strand_ 上执行，会话状态不需要加锁
+    boost::asio::strand<tcp::socket::executor_type> strand_;
     websocket::stream<tcp::socket> ws_;
     boost::beast::flat_buffer buffer_;
-    boost::asio::steady_timer timer_;
     int fps_{0};
-    // frame buffer
-    RenderEngine::Buffer frame_buffer_;
+    // 正在发送的帧，发送完成后释放
+    // 与订阅同一引擎的其他会话共享
+    std::shared_ptr<const PublishedFrame> frame_;
     bool write_in_progress_{false};
 
+    // 帧编码方式
+    enum class Encoding {
+        RAW,    // 每帧发送完整的 RGBA 像素，兼容原有的前端
+        DELTA,  // 发送关键帧和差量帧，见 frame_encoder.hpp
+        QOI,    // 每帧编码为 QOI 图像
+        PNG,    // 每帧编码为 PNG 图像
+    } encoding_{Encoding::RAW};
+    FrameEncoder encoder_;
+    ImageEncoder image_encoder_;
+    // 客户端收到已发送的所有帧后持有的帧，作为下一个差量帧的基准
+    // 基准是最后发送而不是最后确认的帧：同一连接上的消息按序到达且不会丢失，
+    // 客户端只保留当前帧，收到差量帧时持有的正是最后发送的帧；确认只用于限制在途帧数
+    std::shared_ptr<const PublishedFrame> base_;
+    // 需要发送关键帧
+    bool key_requested_{true};
+    // 距上一个关键帧的帧数
+    int frames_since_key_{0};
+    // 已发送、尚未确认的帧版本
+    std::deque<uint64_t> unacked_;
+    // 因等待确认而连续丢弃的帧数
+    int lagging_frames_{0};
+
+    // 每隔多少帧发送一个关键帧
+    static constexpr int keyframe_interval = 120;
+    // 未确认的帧超过此数量时丢帧
+    static constexpr size_t max_unacked_frames = 2;
+    // 确认滞后超过此帧数时不再等待，发送关键帧重新同步
+    static constexpr int max_lagging_frames = 60;
+
    public:
     explicit EngineWebSocketSession(tcp::socket socket);
 
     void run(const http::request<http::string_body>& req);
 
+    void do_read();
+
     void on_read(boost::system::error_code ec, std::size_t bytes_transferred);
 
-    void on_timer(boost::system::error_code ec);
+    void on_frame(const std::shared_ptr<const PublishedFrame> &frame) override;
 
-    void send_frame();
+    void send_frame(const std::shared_ptr<const PublishedFrame> &frame);
+
+    void close();
 
     void set_fps(int fps);
 
+    void set_encoding(const std::string &encoding);
+
+    void on_ack(uint64_t version);
+
+    // 应用客户端发来的二进制图元操作
+    void apply_binary_operations();
+
     void on_write(boost::system::error_code ec, std::size_t bytes_transferred);
 };
 
@@ -0,0 +1,199 @@
+#ifndef RENDERENGINE_FRAMEPUBLISHER_H
+#define RENDERENGINE_FRAMEPUBLISHER_H
+
+#include <algorithm>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "engine.hpp"
+
+// 发布的帧
+// 每次发布只渲染、编码一次，所有订阅者共享同一份数据
+struct PublishedFrame {
+    // 帧版本，每次渲染出新的画面时递增
+    uint64_t version{0};
+    RenderCore::RenderEngine::Frame frame;
+};
+
+// 帧订阅者
+class FrameSubscriber {
+   public:
+    virtual ~FrameSubscriber() = default;
+
+    // 在发布者的线程上调用，订阅者需自行切换到自己的执行器
+    // 上一帧仍在发送时，订阅者应丢弃这一帧
+    virtual void on_frame(const std::shared_ptr<const PublishedFrame> &frame) = 0;
+};
+
+// 帧发布者
+// 每个引擎一个，按订阅者中最高的帧率定时渲染，每个时刻最多渲染一次，再分发给到期的订阅者
+// 所有状态只在 strand_ 上访问
+class FramePublisher : public std::enable_shared_from_this<FramePublisher> {
+   public:
+    // 渲染并取得当前帧，引擎不存在时返回 false
+    using RenderFunction = std::function<bool(PublishedFrame &frame)>;
+
+   private:
+    using clock = std::chrono::steady_clock;
+
+    struct Subscription {
+        std::weak_ptr<FrameSubscriber> subscriber;
+        // 发送间隔，为 0 时只在请求时发送
+        clock::duration interval{};
+        clock::time_point next{};
+        // 请求了一帧
+        bool requested{false};
+    };
+
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+    boost::asio::steady_timer timer_;
+    RenderFunction render_;
+    std::vector<Subscription> subscriptions_;
+    // 上一次发布的帧，画面没有变化时直接复用
+    std::shared_ptr<const PublishedFrame> last_frame_;
+    bool stopped_{false};
+
+    Subscription *find(const std::shared_ptr<FrameSubscriber> &subscriber) {
+        for (auto &subscription : subscriptions_) {
+            if (subscription.subscriber.lock() == subscriber) {
+                return &subscription;
+            }
+        }
+        return nullptr;
+    }
+
+    Subscription &find_or_add(const std::shared_ptr<FrameSubscriber> &subscriber) {
+        if (auto *subscription = find(subscriber)) {
+            return *subscription;
+        }
+        subscriptions_.push_back(
+            {.subscriber = subscriber, .interval = {}, .next = {}, .requested = false});
+        return subscriptions_.back();
+    }
+
+    // 按最早到期的订阅者设置定时器
+    void schedule() {
+        auto next = clock::time_point::max();
+        for (const auto &subscription : subscriptions_) {
+            if (subscription.interval != clock::duration::zero()) {
+                next = std::min(next, subscription.next);
+            }
+        }
+        if (stopped_ || next == clock::time_point::max()) {
+            timer_.cancel();
+            return;
+        }
+        // 重新设置到期时间会取消之前的等待
+        timer_.expires_at(next);
+        timer_.async_wait(boost::asio::bind_executor(
+            strand_, [self = shared_from_this()](const boost::system::error_code &ec) {
+                if (!ec) {
+                    self->publish();
+                }
+            }));
+    }
+
+    // 渲染一次，分发给所有到期的订阅者
+    void publish() {
+        const auto now = clock::now();
+        std::vector<std::shared_ptr<FrameSubscriber>> due;
+        // 每个订阅者只 lock 一次，已经销毁的订阅者在同一次遍历中移除
+        // 先判断 expired 再 lock 时，订阅者可能在两者之间销毁
+        size_t kept = 0;
+        for (auto &subscription : subscriptions_) {
+            auto subscriber = subscription.subscriber.lock();
+            if (!subscriber) {
+                continue;
+            }
+            auto &current = subscriptions_[kept++];
+            if (&current != &subscription) {
+                current = std::move(subscription);
+            }
+            const bool timed =
+                current.interval != clock::duration::zero() && current.next <= now;
+            if (!timed && !current.requested) {
+                continue;
+            }
+            if (timed) {
+                // 落后太多时不补发
+                current.next = std::max(current.next + current.interval, now);
+            }
+            current.requested = false;
+            due.push_back(std::move(subscriber));
+        }
+        subscriptions_.resize(kept);
+        if (!due.empty()) {
+            PublishedFrame frame;
+            if (!render_(frame)) {
+                // 引擎已被移除
+                stopped_ = true;
+                subscriptions_.clear();
+                timer_.cancel();
+                return;
+            }
+            if (!last_frame_ || last_frame_->version != frame.version ||
+                last_frame_->frame != frame.frame) {
+                last_frame_ = std::make_shared<const PublishedFrame>(std::move(frame));
+            }
+            for (const auto &subscriber : due) {
+                subscriber->on_frame(last_frame_);
+            }
+        }
+        schedule();
+    }
+
+   public:
+    FramePublisher(boost::asio::io_context &ioc, RenderFunction render)
+        : strand_(boost::asio::make_strand(ioc)), timer_(strand_), render_(std::move(render)) {}
+
+    // 以指定帧率订阅，fps 为 0 时取消定时发送
+    void subscribe(const std::shared_ptr<FrameSubscriber> &subscriber, int fps) {
+        boost::asio::post(strand_, [self = shared_from_this(), subscriber, fps] {
+            auto &subscription = self->find_or_add(subscriber);
+            subscription.interval =
+                fps > 0 ? std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) / fps
+                        : clock::duration::zero();
+            subscription.next = clock::now();
+            self->schedule();
+        });
+    }
+
+    // 取消订阅
+    void unsubscribe(const std::shared_ptr<FrameSubscriber> &subscriber) {
+        boost::asio::post(strand_, [self = shared_from_this(), subscriber] {
+            std::erase_if(self->subscriptions_, [&](const Subscription &subscription) {
+                return subscription.subscriber.lock() == subscriber;
+            });
+            self->schedule();
+        });
+    }
+
+    // 请求发送一帧
+    // 与同一时刻到期的其他订阅者共享同一次渲染
+    void request_frame(const std::shared_ptr<FrameSubscriber> &subscriber) {
+        boost::asio::post(strand_, [self = shared_from_this(), subscriber] {
+            self->find_or_add(subscriber).requested = true;
+            self->publish();
+        });
+    }
+
+    // 停止发布，引擎移除时调用
+    void stop() {
+        boost::asio::post(strand_, [self = shared_from_this()] {
+            self->stopped_ = true;
+            self->subscriptions_.clear();
+            self->last_frame_.reset();
+            self->timer_.cancel();
+        });
+    }
+};
+
+#endif  //RENDERENGINE_FRAMEPUBLISHER_H
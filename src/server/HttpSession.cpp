@@ -46,10 +46,17 @@ void HttpSession::on_read(boost::system::error_code ec) {
     logger::debug("HTTP request from {}:{} {}", socket_.remote_endpoint().address().to_string(),
         socket_.remote_endpoint().port(), std::string_view(req_.target()));
 
-    handle_request(req_, res_);
+    const bool frame = handle_request(req_, res_, frame_res_);
 
     req_ = {};
 
+    if (frame) {
+        http::async_write(socket_, frame_res_,
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+                self->on_write(ec, self->frame_res_.need_eof());
+            });
+        return;
+    }
     http::async_write(
         socket_, res_, [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
             self->on_write(ec, self->res_.need_eof());
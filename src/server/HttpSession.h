@@ -6,6 +6,7 @@
 #define RENDERENGINE_HTTPSESSION_H
 
 #include "Server.h"
+#include "handle_request.h"
 
 namespace http = boost::beast::http;
 
@@ -14,6 +15,8 @@ class HttpSession : public std::enable_shared_from_this<HttpSession> {
     boost::beast::flat_buffer buffer_;
     http::request<http::string_body> req_;
     http::response<http::string_body> res_;
+    // 取帧请求的响应，发送完成后保留响应体，下一次取帧时复用
+    frame_response frame_res_;
 
    public:
     explicit HttpSession(tcp::socket socket);
@@ -5,11 +5,15 @@
 #include "handle_request.h"
 
 #include <boost/json/src.hpp>
+#include <optional>
+#include <string_view>
 
 #include "EngineManager.h"
 #include "Server.h"
 #include "common_response.hpp"
+#include "primitive_operation.h"
 #include "serialize/serialize.h"
+#include "serialize/serialize_binary.h"
 #include "serialize/serialize_options.h"
 
 using RenderCore::Primitive;
@@ -70,14 +74,74 @@ std::shared_ptr<EngineManager::EngineMutex> get_engine_with_mutex(
     if (engine_name.empty()) {
         return nullptr;
     }
-    if (!EngineManager::get_instance().check_engine(engine_name)) {
+    // 只查找一次，不存在时返回 nullptr
+    auto engine = EngineManager::get_instance().get_engine_with_mutex(engine_name);
+    if (!engine) {
         error_response(res, http::status::not_found, "Engine not found.");
         return nullptr;
     }
-    return EngineManager::get_instance().get_engine_with_mutex(engine_name);
+    return engine;
+}
+
+// 请求体是否为二进制格式，见 serialize_binary.h
+bool is_binary_request(const request &req) {
+    return req[http::field::content_type].starts_with(BINARY_PRIMITIVE_CONTENT_TYPE);
+}
+
+// 在同一次加锁内应用解析好的操作，返回每个操作结果的下标
+void apply_operations(
+    const request &req, response &res, std::vector<PrimitiveOperation> &operations) {
+    auto engine = get_engine_with_mutex(req, res);
+    if (!engine) {
+        return;
+    }
+    logger::trace("Apply {} primitive operations", operations.size());
+    std::vector<size_t> indices;
+    std::optional<size_t> failed;
+    {
+        // 整批操作期间其他线程不能编辑图元，不影响渲染和读取
+        auto lock = engine->engine.lock_edits();
+        failed = apply_primitive_operations(engine->engine, operations, indices);
+    }
+    if (failed) {
+        error_response(res, http::status::bad_request,
+            "Index out of range in operation " + std::to_string(*failed) + ".");
+        return;
+    }
+    success_response(res, "Operations applied.",
+        {{"indices", boost::json::array(indices.begin(), indices.end())}});
+}
+
+// 二进制格式的请求体为连续的多个图元，全部追加到末尾
+void handle_engine_draw_binary(const request &req, response &res) {
+    if (req.method() != http::verb::post) {
+        error_response(res, http::status::bad_request, "The request method must be POST.");
+        return;
+    }
+    std::vector<PrimitiveOperation> operations;
+    try {
+        BinaryReader reader(req.body().data(), req.body().size());
+        while (!reader.empty()) {
+            operations.push_back(PrimitiveOperation{.type = PrimitiveOperation::Type::PUSH_BACK,
+                .primitive = decode_primitive(reader)});
+        }
+    } catch (const std::exception &e) {
+#ifdef NDEBUG
+        auto msg = "Invalid primitive.";
+#else
+        auto msg = "Invalid primitive: " + std::string(e.what());
+#endif
+        error_response(res, http::status::bad_request, msg);
+        return;
+    }
+    apply_operations(req, res, operations);
 }
 
 void handle_engine_draw(const request &req, response &res) {
+    if (is_binary_request(req)) {
+        handle_engine_draw_binary(req, res);
+        return;
+    }
     auto j = get_request_body(req, res);
     if (j.is_null()) {
         return;
@@ -90,11 +154,8 @@ void handle_engine_draw(const request &req, response &res) {
     try {
         auto primitive = deserialize_primitive(j.as_object());
         logger::trace("Add primitive: {}", boost::json::serialize(j));
-        int index;
-        {
-            std::lock_guard<std::mutex> lock(engine_mutex->mutex);
-            index = engine_mutex->engine.add_primitive(primitive);
-        }
+        // 编辑接口由引擎内部同步，不需要等待渲染
+        int index = engine_mutex->engine.add_primitive(primitive);
         success_response(res, "Primitive added.", {{"index", index}});
     } catch (const std::exception &e) {
 #ifdef NDEBUG
@@ -111,13 +172,12 @@ void handle_engine_get_primitives(const request &req, response &res) {
     if (!engine) {
         return;
     }
+    // 在不可变的快照上序列化，不阻塞编辑和渲染
+    auto primitives = engine->engine.get_primitives();
     boost::json::array j_primitives;
-    {
-        std::lock_guard<std::mutex> lock(engine->mutex);
-        auto primitives = engine->engine.get_primitives();
-        for (const auto &primitive : primitives) {
-            j_primitives.push_back(serialize_primitive(primitive));
-        }
+    j_primitives.reserve(primitives->size());
+    for (const auto &primitive : *primitives) {
+        j_primitives.push_back(serialize_primitive(primitive));
     }
     res.result(http::status::ok);
     res.set(http::field::content_type, "application/json");
@@ -139,10 +199,7 @@ void handle_engine_set_global_options(const request &req, response &res) {
     }
     auto global_options = deserialize_global_options(j.at("GlobalOptions").as_object());
     logger::trace("Set global options: {}", boost::json::serialize(j));
-    {
-        std::lock_guard<std::mutex> lock(engine->mutex);
-        engine->engine.set_global_options(global_options);
-    }
+    engine->engine.set_global_options(global_options);
     success_response(res, "Global options set.");
 }
 
@@ -162,10 +219,7 @@ void handle_engine_insert_primitive(const request &req, response &res) {
     auto primitive = deserialize_primitive(j.at("Primitive").as_object());
     auto index = static_cast<size_t>(j.at("Index").as_int64());
     logger::trace("Insert primitive at {}: {}", index, boost::json::serialize(j));
-    {
-        std::lock_guard<std::mutex> lock(engine->mutex);
-        engine->engine.insert_primitive(primitive, index);
-    }
+    engine->engine.insert_primitive(primitive, index);
     success_response(res, "Primitive inserted.");
 }
 
@@ -180,10 +234,7 @@ void handle_engine_remove_primitive(const request &req, response &res) {
     }
     auto index = static_cast<size_t>(j.at("Index").as_int64());
     logger::trace("Remove primitive at {}: {}", index, boost::json::serialize(j));
-    {
-        std::lock_guard<std::mutex> lock(engine->mutex);
-        engine->engine.remove_primitive(index);
-    }
+    engine->engine.remove_primitive(index);
     success_response(res, "Primitive removed.");
 }
 
@@ -203,14 +254,134 @@ void handle_engine_modify_primitive(const request &req, response &res) {
     auto primitive = deserialize_primitive(j.at("Primitive").as_object());
     auto index = static_cast<size_t>(j.at("Index").as_int64());
     logger::trace("Modify primitive at {}: {}", index, boost::json::serialize(j));
+    engine->engine.modify_primitive(index, primitive);
+    success_response(res, "Primitive modified.");
+}
+
+PrimitiveOperation deserialize_primitive_operation(const boost::json::object &j) {
+    PrimitiveOperation operation{};
+    const auto &type = j.at("Type").as_string();
+    if (type == "push_back") {
+        operation.type = PrimitiveOperation::Type::PUSH_BACK;
+    } else if (type == "insert") {
+        operation.type = PrimitiveOperation::Type::INSERT;
+    } else if (type == "remove") {
+        operation.type = PrimitiveOperation::Type::REMOVE;
+    } else if (type == "modify") {
+        operation.type = PrimitiveOperation::Type::MODIFY;
+    } else {
+        throw std::invalid_argument("Unknown operation type: " + std::string(type.c_str()));
+    }
+    if (operation.type != PrimitiveOperation::Type::PUSH_BACK) {
+        operation.index = static_cast<size_t>(j.at("Index").as_int64());
+    }
+    if (operation.type != PrimitiveOperation::Type::REMOVE) {
+        operation.primitive = deserialize_primitive(j.at("Primitive").as_object());
+    }
+    return operation;
+}
+
+void handle_engine_batch(const request &req, response &res) {
+    // 在锁外解析所有操作
+    std::vector<PrimitiveOperation> operations;
+    try {
+        if (is_binary_request(req)) {
+            if (req.method() != http::verb::post) {
+                error_response(res, http::status::bad_request, "The request method must be POST.");
+                return;
+            }
+            operations = decode_primitive_operations(req.body().data(), req.body().size());
+        } else {
+            auto j = get_request_body(req, res);
+            if (j.is_null()) {
+                return;
+            }
+            if (!j.as_object().contains("Operations")) {
+                error_response(res, http::status::bad_request, "Operations not found.");
+                return;
+            }
+            const auto &j_operations = j.at("Operations").as_array();
+            operations.reserve(j_operations.size());
+            for (const auto &j_operation : j_operations) {
+                operations.push_back(deserialize_primitive_operation(j_operation.as_object()));
+            }
+        }
+    } catch (const std::exception &e) {
+#ifdef NDEBUG
+        auto msg = "Invalid operation.";
+#else
+        auto msg = "Invalid operation: " + std::string(e.what());
+#endif
+        error_response(res, http::status::bad_request, msg);
+        return;
+    }
+    apply_operations(req, res, operations);
+}
+
+// 取得请求目标的查询字符串中参数 name 的值，不存在时返回空
+std::optional<std::string_view> query_parameter(std::string_view target, std::string_view name) {
+    const auto question = target.find('?');
+    if (question == std::string_view::npos) {
+        return std::nullopt;
+    }
+    auto query = target.substr(question + 1);
+    query = query.substr(0, query.find('#'));
+    while (!query.empty()) {
+        const auto end = query.find('&');
+        const auto parameter = query.substr(0, end);
+        const auto equal = parameter.find('=');
+        if (parameter.substr(0, equal) == name) {
+            return equal == std::string_view::npos ? std::string_view()
+                                                   : parameter.substr(equal + 1);
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        query = query.substr(end + 1);
+    }
+    return std::nullopt;
+}
+
+// 成功时把图像写入 frame_res 并返回 true
+bool handle_engine_get_frame(const request &req, response &res, frame_response &frame_res) {
+    auto engine = get_engine_with_mutex(req, res);
+    if (!engine) {
+        return false;
+    }
+    // 格式由查询参数 format 指定，默认为 png
+    auto format = RenderCore::ImageFormat::PNG;
+    const std::string target(req.target());
+    if (const auto name = query_parameter(target, "format")) {
+        auto parsed = RenderCore::image_format_from_name(std::string(*name));
+        if (!parsed) {
+            error_response(res, http::status::bad_request, "Unsupported image format.");
+            return false;
+        }
+        format = *parsed;
+    }
+    RenderEngine::Frame frame;
     {
         std::lock_guard<std::mutex> lock(engine->mutex);
-        engine->engine.modify_primitive(index, primitive);
+        engine->engine.render();
+        frame = engine->engine.get_frame();
     }
-    success_response(res, "Primitive modified.");
+    if (!frame) {
+        error_response(res, http::status::bad_request, "Engine not initialized.");
+        return false;
+    }
+    // 在锁外编码快照，每个线程复用自己的编码器
+    // 上一次取帧的响应体交还给编码器，编码结果再移入响应体，不复制图像数据
+    thread_local RenderCore::ImageEncoder encoder;
+    encoder.reuse_buffer(std::move(frame_res.body()));
+    encoder.encode(*frame, format);
+    frame_res.base() = res.base();
+    frame_res.result(http::status::ok);
+    frame_res.set(http::field::content_type, RenderCore::image_mime_type(format));
+    frame_res.body() = encoder.take_buffer();
+    return true;
 }
 
-void handle_request(const request &req, response &res) {
+bool handle_request(const request &req, response &res, frame_response &frame_res) {
     res.version(req.version());
     res.set(http::field::server, SERVER_NAME);
     res.set(http::field::access_control_allow_origin, ENGINE_ALLOW_ORIGIN);
@@ -222,7 +393,7 @@ void handle_request(const request &req, response &res) {
     if (req.method() == http::verb::options) {
         res.result(http::status::ok);
         res.prepare_payload();
-        return;
+        return false;
     }
 
     try {
@@ -239,17 +410,24 @@ void handle_request(const request &req, response &res) {
                 handle_engine_remove_primitive(req, res);
             } else if (req.target().starts_with("/engine/primitive/modify")) {
                 handle_engine_modify_primitive(req, res);
+            } else if (req.target().starts_with("/engine/primitive/batch")) {
+                handle_engine_batch(req, res);
             } else if (req.target().starts_with("/engine/primitive/get_all")) {
                 handle_engine_get_primitives(req, res);
             } else if (req.target().starts_with("/engine/set_global_options")) {
                 handle_engine_set_global_options(req, res);
+            } else if (req.target().starts_with("/engine/frame")) {
+                if (handle_engine_get_frame(req, res, frame_res)) {
+                    frame_res.prepare_payload();
+                    return true;
+                }
             } else if (req.target().starts_with("/engine/ws")) {
                 res.result(http::status::ok);
             } else {
-                return not_found_response(req, res);
+                not_found_response(req, res);
             }
         } else {
-            return not_found_response(req, res);
+            not_found_response(req, res);
         }
     } catch (const std::exception &e) {
 #ifdef NDEBUG
@@ -260,4 +438,5 @@ void handle_request(const request &req, response &res) {
         error_response(res, http::status::bad_request, msg);
     }
     res.prepare_payload();
+    return false;
 }
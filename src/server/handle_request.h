@@ -6,10 +6,16 @@
 #define RENDERENGINE_HANDLE_REQUEST_H
 
 #include <boost/beast.hpp>
+#include <cstdint>
 
 namespace http = boost::beast::http;
 
-void handle_request(
-    const http::request<http::string_body>& req, http::response<http::string_body>& res);
+// 取帧请求的响应，图像编码结果直接作为响应体发送
+using frame_response = http::response<http::vector_body<uint8_t>>;
+
+// 处理请求，返回 true 时响应在 frame_res 中，否则在 res 中
+// frame_res 的响应体在下一次取帧时交还给编码器复用
+bool handle_request(const http::request<http::string_body>& req,
+    http::response<http::string_body>& res, frame_response& frame_res);
 
 #endif  //RENDERENGINE_HANDLE_REQUEST_H
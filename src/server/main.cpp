@@ -15,7 +15,10 @@ int main(int argc, char *argv[]) {
     desc.add_options()("help,h", "produce help message")(
         "port,p", po::value<unsigned short>()->default_value(3000), "set port number")(
         "address,a", po::value<std::string>()->default_value("0.0.0.0"), "set server address")(
-        "threads,t", po::value<int>()->default_value(4), "set number of threads");
+        "threads,t", po::value<int>()->default_value(4), "set number of threads")(
+        "render-threads,r", po::value<int>()->default_value(1),
+        "set number of render threads per engine")("engine-timeout,e",
+        po::value<int>()->default_value(30), "set idle timeout of engines in seconds");
 
     // 存储命令行参数的变量
     po::variables_map vm;
@@ -38,9 +41,18 @@ int main(int argc, char *argv[]) {
     auto const address = boost::asio::ip::make_address(vm["address"].as<std::string>());
     auto const port = vm["port"].as<unsigned short>();
     auto const threads = vm["threads"].as<int>();
+    auto const render_threads = vm["render-threads"].as<int>();
+    auto const engine_timeout = vm["engine-timeout"].as<int>();
+    if (engine_timeout <= 0) {
+        std::cerr << "engine-timeout must be positive" << std::endl;
+        return 1;
+    }
 
     init_logger();
 
+    EngineManager::get_instance().set_render_threads(render_threads);
+    EngineManager::get_instance().set_engine_timeout(std::chrono::seconds(engine_timeout));
+
     logger::info("Server started");
 
     logger::info("Server listening on: {}:{}", address.to_string(), port);
@@ -48,6 +60,9 @@ int main(int argc, char *argv[]) {
     // The io_context is required for all I/O
     boost::asio::io_context ioc{threads};
 
+    // 渲染在服务器的线程上进行，线程数由 --threads 决定
+    EngineManager::get_instance().set_publish_io_context(ioc);
+
     // Create and launch a listening port
     std::make_shared<Listener>(ioc, tcp::endpoint{address, port})->run();
 
@@ -0,0 +1,70 @@
+#ifndef RENDERENGINE_PRIMITIVE_OPERATION_H
+#define RENDERENGINE_PRIMITIVE_OPERATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "engine.hpp"
+#include "primitive.hpp"
+
+// 批量操作中的一项
+struct PrimitiveOperation {
+    enum class Type { PUSH_BACK, INSERT, REMOVE, MODIFY } type;
+    size_t index{0};
+    RenderCore::Primitive primitive;
+};
+
+// 在同一次加锁内应用一批操作，调用者需通过 lock_edits() 持有引擎的编辑锁
+// 先检查所有下标，全部有效时才修改，保证整批操作要么全部生效，要么都不生效
+// 返回第一个下标越界的操作的序号，成功时返回空，indices 为每个操作结果的下标
+inline std::optional<size_t> apply_primitive_operations(RenderCore::RenderEngine &engine,
+    std::vector<PrimitiveOperation> &operations, std::vector<size_t> &indices) {
+    size_t count = engine.get_primitive_count();
+    for (size_t i = 0; i < operations.size(); i++) {
+        const auto &operation = operations[i];
+        switch (operation.type) {
+            case PrimitiveOperation::Type::PUSH_BACK:
+            case PrimitiveOperation::Type::INSERT:
+                count++;
+                break;
+            case PrimitiveOperation::Type::REMOVE:
+            case PrimitiveOperation::Type::MODIFY:
+                if (operation.index >= count) {
+                    return i;
+                }
+                if (operation.type == PrimitiveOperation::Type::REMOVE) {
+                    count--;
+                }
+                break;
+        }
+    }
+    indices.clear();
+    indices.reserve(operations.size());
+    for (auto &operation : operations) {
+        switch (operation.type) {
+            case PrimitiveOperation::Type::PUSH_BACK:
+                indices.push_back(engine.get_primitive_count());
+                engine.add_primitive(std::move(operation.primitive));
+                break;
+            case PrimitiveOperation::Type::INSERT:
+                // 超出范围时追加到末尾
+                operation.index = std::min(operation.index, engine.get_primitive_count());
+                engine.insert_primitive(std::move(operation.primitive), operation.index);
+                indices.push_back(operation.index);
+                break;
+            case PrimitiveOperation::Type::REMOVE:
+                engine.remove_primitive(operation.index);
+                indices.push_back(operation.index);
+                break;
+            case PrimitiveOperation::Type::MODIFY:
+                engine.modify_primitive(operation.index, std::move(operation.primitive));
+                indices.push_back(operation.index);
+                break;
+        }
+    }
+    return std::nullopt;
+}
+
+#endif  //RENDERENGINE_PRIMITIVE_OPERATION_H
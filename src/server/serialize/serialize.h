@@ -24,6 +24,8 @@ inline RenderCore::Primitive deserialize_primitive(const boost::json::object &pr
         return deserialize_circle(primitive.at("Circle").as_object());
     } else if (primitive.contains("Arc")) {
         return deserialize_arc(primitive.at("Arc").as_object());
+    } else if (primitive.contains("Ellipse")) {
+        return deserialize_ellipse(primitive.at("Ellipse").as_object());
     } else if (primitive.contains("PenOptions")) {
         return deserialize_pen_options(primitive.at("PenOptions").as_object());
     } else if (primitive.contains("Polygon")) {
@@ -50,6 +52,8 @@ inline boost::json::object serialize_primitive(const RenderCore::Primitive &prim
         return {{"Circle", serialize_circle(std::get<RenderCore::Circle>(primitive))}};
     } else if (std::holds_alternative<RenderCore::Arc>(primitive)) {
         return {{"Arc", serialize_arc(std::get<RenderCore::Arc>(primitive))}};
+    } else if (std::holds_alternative<RenderCore::Ellipse>(primitive)) {
+        return {{"Ellipse", serialize_ellipse(std::get<RenderCore::Ellipse>(primitive))}};
     } else if (std::holds_alternative<RenderCore::PenOptions>(primitive)) {
         return {{"PenOptions", serialize_pen_options(std::get<RenderCore::PenOptions>(primitive))}};
     } else if (std::holds_alternative<RenderCore::Polygon>(primitive)) {
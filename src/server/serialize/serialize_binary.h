@@ -0,0 +1,328 @@
+#ifndef RENDERENGINE_SERIALIZE_BINARY_H
+#define RENDERENGINE_SERIALIZE_BINARY_H
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "../primitive_operation.h"
+#include "primitive.hpp"
+
+// 图元的二进制格式
+// 比 JSON 紧凑，解码时直接构造引擎的类型，不经过 JSON DOM
+//
+// 基本类型（小端序）：
+//   u8     1 字节
+//   varint 无符号 LEB128
+//   int    zigzag 编码后的 varint
+//   f32    IEEE 754 单精度浮点数
+//   point  int x, int y
+//   delta  相对上一个点的差值，int dx, int dy
+//   points varint 点数，第一个点为 point，之后为 delta
+//   color  u8 r, g, b, a（0 ~ 255）
+//
+// 图元：u8 类型标签，与 Primitive 中的顺序一致，之后为图元的数据
+//   0  Line          point p1, delta p2, u8 algorithm
+//   1  Circle        u8 0: point center, int radius
+//                    u8 1: point p1, delta p2, delta p3
+//   2  Arc           u8 0: point center, int radius, f32 start_angle, f32 end_angle
+//                    u8 1: point p1, delta p2, delta p3
+//   3  Rectangle     point top_left, delta bottom_right
+//   4  Polygon       points
+//   5  Fill          point seed, u8 connectivity
+//   6  PenOptions    color color, color fill_color, int width, u8 type, int dash, u8 fill_rule,
+//                    u8 cap, u8 join
+//   7  Transform     u8 0: f32 x, f32 y
+//                    u8 1: f32 angle, point center
+//                    u8 2: f32 x, f32 y, point center
+//   8  BezierCurve   points
+//   9  BsplineCurve  points, varint 节点数, f32 节点
+//   10 Ellipse       point center, int radius_x, int radius_y
+//   11 空图元
+//   未知的标签、超出枚举范围的值、超出 int 范围的坐标都会导致解码失败
+//
+// 批量操作：varint 操作数，之后为每个操作
+//   u8 类型（0 push_back，1 insert，2 remove，3 modify），insert/remove/modify 为 varint 下标，
+//   push_back/insert/modify 为图元
+
+// HTTP 请求使用二进制格式时的 Content-Type
+constexpr const char *BINARY_PRIMITIVE_CONTENT_TYPE = "application/x-renderengine-primitive";
+
+class BinaryReader {
+    const uint8_t *data_;
+    const uint8_t *end_;
+
+    void require(size_t size) const {
+        if (static_cast<size_t>(end_ - data_) < size) {
+            throw std::invalid_argument("Unexpected end of binary primitive data.");
+        }
+    }
+
+    // 坐标加上差值，结果超出 int 范围时抛出异常
+    static int add_delta(int value, int delta) {
+        const int64_t result = static_cast<int64_t>(value) + delta;
+        if (result < std::numeric_limits<int>::min() ||
+            result > std::numeric_limits<int>::max()) {
+            throw std::invalid_argument("Point delta out of range.");
+        }
+        return static_cast<int>(result);
+    }
+
+   public:
+    BinaryReader(const void *data, size_t size)
+        : data_(static_cast<const uint8_t *>(data)), end_(data_ + size) {}
+
+    [[nodiscard]] bool empty() const { return data_ == end_; }
+
+    // 检查剩余数据至少能容纳 count 个 size 字节的元素，防止恶意的数量导致过大的分配
+    void require_elements(uint64_t count, size_t size) const {
+        if (count > static_cast<uint64_t>(end_ - data_) / size) {
+            throw std::invalid_argument("Unexpected end of binary primitive data.");
+        }
+    }
+
+    uint8_t read_u8() {
+        require(1);
+        return *data_++;
+    }
+
+    // 读取 u8 枚举值，超出 [0, last] 时抛出异常
+    template <typename Enum>
+    Enum read_enum(Enum last) {
+        const uint8_t value = read_u8();
+        if (value > static_cast<uint8_t>(last)) {
+            throw std::invalid_argument("Invalid enum value in binary primitive data.");
+        }
+        return static_cast<Enum>(value);
+    }
+
+    uint64_t read_varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = read_u8();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::invalid_argument("Varint too long.");
+    }
+
+    // zigzag 编码的 varint 超过 32 位时超出 int 范围，抛出异常
+    int read_int() {
+        const auto varint = read_varint();
+        if (varint > std::numeric_limits<uint32_t>::max()) {
+            throw std::invalid_argument("Integer out of range.");
+        }
+        const auto value = static_cast<uint32_t>(varint);
+        return static_cast<int>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    float read_f32() {
+        require(4);
+        const uint32_t bits = static_cast<uint32_t>(data_[0]) | (data_[1] << 8) |
+                              (data_[2] << 16) | (static_cast<uint32_t>(data_[3]) << 24);
+        data_ += 4;
+        float value;
+        std::memcpy(&value, &bits, 4);
+        return value;
+    }
+
+    RenderCore::Point read_point() {
+        const int x = read_int();
+        const int y = read_int();
+        return {x, y};
+    }
+
+    RenderCore::Point read_delta(const RenderCore::Point &prev) {
+        const int x = add_delta(prev.x, read_int());
+        const int y = add_delta(prev.y, read_int());
+        return {x, y};
+    }
+
+    // 读取点列表，追加到 points
+    template <typename Container>
+    void read_points(Container &points) {
+        const auto count = read_varint();
+        // 每个点至少 2 字节
+        require_elements(count, 2);
+        points.reserve(points.size() + count);
+        RenderCore::Point prev{0, 0};
+        for (uint64_t i = 0; i < count; i++) {
+            prev = i == 0 ? read_point() : read_delta(prev);
+            points.push_back(prev);
+        }
+    }
+
+    RenderCore::Color read_color() {
+        require(4);
+        RenderCore::Color color{static_cast<float>(data_[0]) / 255.0f,
+            static_cast<float>(data_[1]) / 255.0f, static_cast<float>(data_[2]) / 255.0f,
+            static_cast<float>(data_[3]) / 255.0f};
+        data_ += 4;
+        return color;
+    }
+};
+
+inline RenderCore::Primitive decode_primitive(BinaryReader &reader) {
+    using namespace RenderCore;
+    switch (reader.read_u8()) {
+        case 0: {
+            Line line;
+            line.p1 = reader.read_point();
+            line.p2 = reader.read_delta(line.p1);
+            line.algorithm = reader.read_enum(Line::LineAlgorithm::BRESENHAM);
+            return line;
+        }
+        case 1:
+            switch (reader.read_u8()) {
+                case 0: {
+                    CircleUseCenterRadius circle;
+                    circle.center = reader.read_point();
+                    circle.radius = reader.read_int();
+                    return Circle{circle};
+                }
+                case 1: {
+                    CircleUseThreePoints circle;
+                    circle.p1 = reader.read_point();
+                    circle.p2 = reader.read_delta(circle.p1);
+                    circle.p3 = reader.read_delta(circle.p2);
+                    return Circle{circle};
+                }
+                default:
+                    throw std::invalid_argument("Unknown circle tag.");
+            }
+        case 2:
+            switch (reader.read_u8()) {
+                case 0: {
+                    ArcUseCenterRadiusAngle arc;
+                    arc.center = reader.read_point();
+                    arc.radius = reader.read_int();
+                    arc.start_angle = reader.read_f32();
+                    arc.end_angle = reader.read_f32();
+                    return Arc{arc};
+                }
+                case 1: {
+                    ArcUseThreePoints arc;
+                    arc.p1 = reader.read_point();
+                    arc.p2 = reader.read_delta(arc.p1);
+                    arc.p3 = reader.read_delta(arc.p2);
+                    return Arc{arc};
+                }
+                default:
+                    throw std::invalid_argument("Unknown arc tag.");
+            }
+        case 3: {
+            Rectangle rectangle;
+            rectangle.top_left = reader.read_point();
+            rectangle.bottom_right = reader.read_delta(rectangle.top_left);
+            return rectangle;
+        }
+        case 4: {
+            Polygon polygon;
+            reader.read_points(polygon);
+            return polygon;
+        }
+        case 5: {
+            const auto seed = reader.read_point();
+            return Fill{seed, reader.read_enum(Fill::Connectivity::EIGHT)};
+        }
+        case 6: {
+            PenOptions options;
+            options.color = reader.read_color();
+            options.fill_color = reader.read_color();
+            options.width = reader.read_int();
+            options.type = reader.read_enum(PenOptions::LineType::DASH_DOT);
+            options.dash = reader.read_int();
+            options.fill_rule = reader.read_enum(PenOptions::FillRule::NON_ZERO);
+            options.cap = reader.read_enum(PenOptions::LineCap::ROUND);
+            options.join = reader.read_enum(PenOptions::LineJoin::ROUND);
+            return options;
+        }
+        case 7:
+            switch (reader.read_u8()) {
+                case 0: {
+                    const float x = reader.read_f32();
+                    const float y = reader.read_f32();
+                    return Transform{make_translate(x, y)};
+                }
+                case 1: {
+                    const float angle = reader.read_f32();
+                    return Transform{make_rotate(angle, reader.read_point())};
+                }
+                case 2: {
+                    const float x = reader.read_f32();
+                    const float y = reader.read_f32();
+                    return Transform{make_scale(x, y, reader.read_point())};
+                }
+                default:
+                    throw std::invalid_argument("Unknown transform tag.");
+            }
+        case 8: {
+            BezierCurve curve;
+            reader.read_points(curve);
+            return curve;
+        }
+        case 9: {
+            BsplineCurve curve;
+            reader.read_points(curve.control_points);
+            const auto count = reader.read_varint();
+            reader.require_elements(count, 4);
+            curve.knots.reserve(count);
+            for (uint64_t i = 0; i < count; i++) {
+                curve.knots.push_back(reader.read_f32());
+            }
+            return curve;
+        }
+        case 10: {
+            Ellipse ellipse;
+            ellipse.center = reader.read_point();
+            ellipse.radius_x = reader.read_int();
+            ellipse.radius_y = reader.read_int();
+            return ellipse;
+        }
+        case 11:
+            return std::monostate{};
+        default:
+            throw std::invalid_argument("Unknown primitive tag.");
+    }
+}
+
+inline PrimitiveOperation decode_primitive_operation(BinaryReader &reader) {
+    PrimitiveOperation operation{};
+    const auto type = reader.read_u8();
+    if (type > static_cast<uint8_t>(PrimitiveOperation::Type::MODIFY)) {
+        throw std::invalid_argument("Unknown operation type: " + std::to_string(type));
+    }
+    operation.type = static_cast<PrimitiveOperation::Type>(type);
+    if (operation.type != PrimitiveOperation::Type::PUSH_BACK) {
+        operation.index = reader.read_varint();
+    }
+    if (operation.type != PrimitiveOperation::Type::REMOVE) {
+        operation.primitive = decode_primitive(reader);
+    }
+    return operation;
+}
+
+// 解码一批操作，数据需被完整读取
+inline std::vector<PrimitiveOperation> decode_primitive_operations(const void *data, size_t size) {
+    BinaryReader reader(data, size);
+    const auto count = reader.read_varint();
+    std::vector<PrimitiveOperation> operations;
+    // 每个操作至少 2 字节
+    reader.require_elements(count, 2);
+    operations.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        operations.push_back(decode_primitive_operation(reader));
+    }
+    if (!reader.empty()) {
+        throw std::invalid_argument("Trailing data after primitive operations.");
+    }
+    return operations;
+}
+
+#endif  //RENDERENGINE_SERIALIZE_BINARY_H
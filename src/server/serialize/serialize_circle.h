@@ -65,4 +65,15 @@ inline RenderCore::Arc deserialize_arc(const boost::json::object &obj) {
     return {};
 }
 
+inline boost::json::object serialize_ellipse(const RenderCore::Ellipse &ellipse) {
+    return {{"center", serialize_point(ellipse.center)}, {"radius_x", ellipse.radius_x},
+        {"radius_y", ellipse.radius_y}};
+}
+
+inline RenderCore::Ellipse deserialize_ellipse(const boost::json::object &obj) {
+    return RenderCore::Ellipse{.center = deserialize_point(obj.at("center").as_object()),
+        .radius_x = static_cast<int>(obj.at("radius_x").as_int64()),
+        .radius_y = static_cast<int>(obj.at("radius_y").as_int64())};
+}
+
 #endif
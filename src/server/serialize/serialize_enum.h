@@ -0,0 +1,20 @@
+#ifndef RENDERENGINE_SERIALIZE_ENUM_H
+#define RENDERENGINE_SERIALIZE_ENUM_H
+
+#include <boost/json.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// 读取枚举值，超出 [0, last] 时抛出 std::invalid_argument
+template <typename Enum>
+Enum deserialize_enum(const boost::json::value &value, Enum last, const char *name) {
+    const auto number = value.as_int64();
+    if (number < 0 || number > static_cast<int64_t>(last)) {
+        throw std::invalid_argument(
+            std::string("Invalid ") + name + ": " + std::to_string(number));
+    }
+    return static_cast<Enum>(number);
+}
+
+#endif  //RENDERENGINE_SERIALIZE_ENUM_H
@@ -7,13 +7,21 @@
 #include <boost/json.hpp>
 
 #include "fill.hpp"
+#include "serialize_enum.h"
 #include "serialize_point.h"
 
 inline boost::json::object serialize_fill(const RenderCore::Fill &fill) {
-    return {{"seed", serialize_point(fill.seed)}};
+    return {{"seed", serialize_point(fill.seed)},
+        {"connectivity", static_cast<int64_t>(fill.connectivity)}};
 }
 
 inline RenderCore::Fill deserialize_fill(const boost::json::object &obj) {
-    return RenderCore::Fill{.seed = deserialize_point(obj.at("seed").as_object())};
+    auto fill = RenderCore::Fill{.seed = deserialize_point(obj.at("seed").as_object())};
+    // 连通方式可选，默认为四连通
+    if (obj.contains("connectivity")) {
+        fill.connectivity = deserialize_enum(
+            obj.at("connectivity"), RenderCore::Fill::Connectivity::EIGHT, "connectivity");
+    }
+    return fill;
 }
 #endif  //RENDERENGINE_SERIALIZE_FILL_H
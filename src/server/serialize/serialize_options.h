@@ -5,34 +5,70 @@
 #define RENDERENGINE_SERIALIZE_OPTIONS_H
 
 #include <boost/json.hpp>
+#include <cmath>
+#include <stdexcept>
+#include <string>
 
 #include "options.hpp"
 #include "serialize_clip.h"
 #include "serialize_color.h"
+#include "serialize_enum.h"
 
 inline boost::json::object serialize_pen_options(const RenderCore::PenOptions &options) {
     return {{"color", serialize_color(options.color)},
         {"fill_color", serialize_color(options.fill_color)}, {"width", options.width},
-        {"type", static_cast<int64_t>(options.type)}, {"dash", options.dash}};
+        {"type", static_cast<int64_t>(options.type)}, {"dash", options.dash},
+        {"cap", static_cast<int64_t>(options.cap)}, {"join", static_cast<int64_t>(options.join)},
+        {"fill_rule", static_cast<int64_t>(options.fill_rule)}};
 }
 
 inline RenderCore::PenOptions deserialize_pen_options(const boost::json::object &obj) {
-    return RenderCore::PenOptions{.color = deserialize_color(obj.at("color").as_object()),
+    auto options = RenderCore::PenOptions{.color = deserialize_color(obj.at("color").as_object()),
         .fill_color = deserialize_color(obj.at("fill_color").as_object()),
         .width = static_cast<int>(obj.at("width").as_int64()),
         .type = static_cast<RenderCore::PenOptions::LineType>(obj.at("type").as_int64()),
         .dash = static_cast<int>(obj.at("dash").as_int64())};
+    // 端点、拐角样式和填充规则可选，默认为方头、尖角和奇偶规则
+    if (obj.contains("cap")) {
+        options.cap =
+            deserialize_enum(obj.at("cap"), RenderCore::PenOptions::LineCap::ROUND, "cap");
+    }
+    if (obj.contains("join")) {
+        options.join =
+            deserialize_enum(obj.at("join"), RenderCore::PenOptions::LineJoin::ROUND, "join");
+    }
+    if (obj.contains("fill_rule")) {
+        options.fill_rule = deserialize_enum(
+            obj.at("fill_rule"), RenderCore::PenOptions::FillRule::NON_ZERO, "fill_rule");
+    }
+    return options;
 }
 
 inline boost::json::object serialize_global_options(const RenderCore::GlobalOptions &options) {
     return {{"background_color", serialize_color(options.background_color)},
-        {"clip", serialize_clip(options.clip)}};
+        {"clip", serialize_clip(options.clip)},
+        {"blend_mode", static_cast<int64_t>(options.blend_mode)},
+        {"curve_tolerance", options.curve_tolerance}};
 }
 
 inline RenderCore::GlobalOptions deserialize_global_options(const boost::json::object &obj) {
-    return RenderCore::GlobalOptions{
+    auto options = RenderCore::GlobalOptions{
         .background_color = deserialize_color(obj.at("background_color").as_object()),
         .clip = deserialize_clip(obj.at("clip").as_object())};
+    // 混合模式可选，默认为浮点混合
+    if (obj.contains("blend_mode")) {
+        options.blend_mode =
+            deserialize_enum(obj.at("blend_mode"), RenderCore::BlendMode::FIXED, "blend_mode");
+    }
+    // 曲线的折线化偏差可选，默认为 0.5 像素，需为正数
+    if (obj.contains("curve_tolerance")) {
+        const auto tolerance = obj.at("curve_tolerance").to_number<double>();
+        if (!(tolerance > 0) || !std::isfinite(tolerance)) {
+            throw std::invalid_argument("Invalid curve_tolerance: " + std::to_string(tolerance));
+        }
+        options.curve_tolerance = static_cast<float>(tolerance);
+    }
+    return options;
 }
 
 #endif